@@ -0,0 +1,121 @@
+/** @file
+ * Measures how the distance matrix scales with the number of threads.
+ *
+ * Usage: matrix_benchmark [side] [cities] [threads]
+ *
+ * A square grid of cities is made through the map interface and the
+ * distances between a number of random cities, each of them both a source
+ * and a target, are found with no extra threads and then with one more at a
+ * time, up to the given number. The matrices found are compared to make
+ * sure that the threads don't change the results.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "map.h"
+
+#define NAME_LENGTH 48
+
+//! @cond
+static unsigned uniform(unsigned low, unsigned high) {
+	return low + (unsigned) (rand() % (int) (high - low + 1));
+}
+
+static void name(char *dest, size_t x, size_t y) {
+	snprintf(dest, NAME_LENGTH, "c%zu_%zu", x, y);
+}
+
+static Map *makeGrid(size_t side) {
+	Map *map = newMap();
+	if (map == NULL)
+		return NULL;
+	char name1[NAME_LENGTH], name2[NAME_LENGTH];
+	for (size_t y = 0; y < side; ++y) {
+		for (size_t x = 0; x < side; ++x) {
+			name(name1, x, y);
+			if (x + 1 < side) {
+				name(name2, x + 1, y);
+				if (!addRoad(map, name1, name2, uniform(1, 100), (int) uniform(1950, 2020)))
+					return NULL;
+			}
+			if (y + 1 < side) {
+				name(name2, x, y + 1);
+				if (!addRoad(map, name1, name2, uniform(1, 100), (int) uniform(1950, 2020)))
+					return NULL;
+			}
+		}
+	}
+	return map;
+}
+
+static double now(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static bool same(const CityDistance *a, const CityDistance *b, size_t length) {
+	for (size_t i = 0; i < length; ++i) {
+		if (a[i].distance != b[i].distance || a[i].year != b[i].year || a[i].unique != b[i].unique)
+			return false;
+	}
+	return true;
+}
+//! @endcond
+
+/** @brief Runs the benchmark.
+ * @param[in] argc number of arguments
+ * @param[in] argv side of the grid, number of cities and of threads, all optional
+ * @return 0 if all matrices agreed, 1 otherwise
+ */
+int main(int argc, char **argv) {
+	const size_t side = (argc > 1 ? strtoul(argv[1], NULL, 10) : 200);
+	const size_t count = (argc > 2 ? strtoul(argv[2], NULL, 10) : 1000);
+	const unsigned threads = (unsigned) (argc > 3 ? strtoul(argv[3], NULL, 10) : 4);
+	int ans = 0;
+	srand(42);
+	Map *map = (side > 0 ? makeGrid(side) : NULL);
+	char *names = malloc(count * NAME_LENGTH);
+	const char **cities = malloc(count * sizeof(char *));
+	CityDistance *first = malloc(count * count * sizeof(CityDistance));
+	CityDistance *distances = malloc(count * count * sizeof(CityDistance));
+	if (!map || !names || !cities || !first || !distances || count == 0) {
+		fprintf(stderr, "usage: %s [side] [cities] [threads]\n", argv[0]);
+		return 1;
+	}
+	for (size_t i = 0; i < count; ++i) {
+		name(names + i * NAME_LENGTH, (size_t) rand() % side, (size_t) rand() % side);
+		cities[i] = names + i * NAME_LENGTH;
+	}
+	printf("%zu cities, %zu x %zu matrix\n", side * side, count, count);
+	printf("%8s %12s %9s\n", "threads", "time [ms]", "speedup");
+	double base = 0;
+	for (unsigned i = 0; i <= threads; ++i) {
+		if (!mapPrepareWorkers(map, i)) {
+			fprintf(stderr, "can't start %u threads\n", i);
+			return 1;
+		}
+		const double start = now();
+		if (!mapDistanceMatrix(map, cities, count, cities, count, i == 0 ? first : distances)) {
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+		const double time = 1000.0 * (now() - start);
+		if (i == 0)
+			base = time;
+		printf("%8u %12.1f %8.2fx\n", i + 1, time, base / time);
+		if (i > 0 && !same(first, distances, count * count)) {
+			printf("  the matrix differs from the one found by a single thread\n");
+			ans = 1;
+		}
+	}
+	free(first);
+	free(distances);
+	free(cities);
+	free(names);
+	deleteMap(map);
+	return ans;
+}
@@ -0,0 +1,238 @@
+/** @file
+ * Compares the engines of the path search queue on grid-shaped road maps.
+ *
+ * Usage: queue_benchmark [side] [searches]
+ *
+ * For every distribution of road lengths a square grid of cities is made
+ * and searches from random cities are run until the whole grid is settled,
+ * once with the heap engine and once with buckets. The distances found by
+ * both engines are compared to make sure that they agree.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "queue.h"
+
+/// A road map in adjacency array form.
+typedef struct Grid Grid;
+
+/// A distribution of road lengths.
+typedef struct Distribution Distribution;
+
+//! @cond
+struct Grid {
+	size_t cityCount;
+	size_t *first;
+	size_t *targets;
+	unsigned *lengths;
+	int *years;
+	unsigned longest;
+	unsigned pad;
+};
+
+struct Distribution {
+	const char *name;
+	unsigned (*draw)(void);
+};
+
+// the queue only carries city pointers, these stand in for real cities
+static char *stubs;
+
+static unsigned uniform(unsigned low, unsigned high) {
+	return low + (unsigned) (rand() % (int) (high - low + 1));
+}
+
+static unsigned drawShort(void) {
+	return uniform(1, 10);
+}
+
+static unsigned drawMedium(void) {
+	return uniform(1, 100);
+}
+
+static unsigned drawLong(void) {
+	return uniform(1, 1000);
+}
+
+// mostly streets in towns, sometimes a long road between them
+static unsigned drawMixed(void) {
+	return (rand() % 10 ? uniform(1, 20) : uniform(200, 1000));
+}
+
+static unsigned drawHuge(void) {
+	return uniform(1, 100000);
+}
+
+static void addRoad(Grid *grid, size_t *count, size_t from, size_t to, unsigned length, int year) {
+	size_t i = grid->first[from] + count[from]++;
+	grid->targets[i] = to;
+	grid->lengths[i] = length;
+	grid->years[i] = year;
+}
+
+static Grid makeGrid(size_t side, unsigned (*draw)(void)) {
+	const size_t n = side * side;
+	Grid grid = (Grid) {.cityCount = n, .longest = 0};
+	size_t *count = calloc(n, sizeof(size_t));
+	grid.first = malloc((n + 1) * sizeof(size_t));
+	grid.targets = malloc(4 * n * sizeof(size_t));
+	grid.lengths = malloc(4 * n * sizeof(unsigned));
+	grid.years = malloc(4 * n * sizeof(int));
+	if (!count || !grid.first || !grid.targets || !grid.lengths || !grid.years) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	for (size_t i = 0; i <= n; ++i)
+		grid.first[i] = 4 * i;
+	for (size_t y = 0; y < side; ++y) {
+		for (size_t x = 0; x < side; ++x) {
+			size_t city = y * side + x;
+			if (x + 1 < side) {
+				unsigned length = draw();
+				int year = (int) uniform(1950, 2020);
+				addRoad(&grid, count, city, city + 1, length, year);
+				addRoad(&grid, count, city + 1, city, length, year);
+				if (length > grid.longest)
+					grid.longest = length;
+			}
+			if (y + 1 < side) {
+				unsigned length = draw();
+				int year = (int) uniform(1950, 2020);
+				addRoad(&grid, count, city, city + side, length, year);
+				addRoad(&grid, count, city + side, city, length, year);
+				if (length > grid.longest)
+					grid.longest = length;
+			}
+		}
+	}
+	// close the gaps left by cities on the edges
+	size_t end = 0;
+	for (size_t i = 0; i < n; ++i) {
+		size_t start = grid.first[i];
+		grid.first[i] = end;
+		for (size_t j = 0; j < count[i]; ++j, ++end) {
+			grid.targets[end] = grid.targets[start + j];
+			grid.lengths[end] = grid.lengths[start + j];
+			grid.years[end] = grid.years[start + j];
+		}
+	}
+	grid.first[n] = end;
+	free(count);
+	return grid;
+}
+
+static void freeGrid(Grid *grid) {
+	free(grid->first);
+	free(grid->targets);
+	free(grid->lengths);
+	free(grid->years);
+}
+
+// settles every city, returns the sum of the distances as a checksum
+static uint64_t search(Heap *queue, const Grid *grid, size_t source, unsigned maxLength,
+		size_t *distance, int *year, unsigned char *settled) {
+	uint64_t ans = 0;
+	for (size_t i = 0; i < grid->cityCount; ++i) {
+		distance[i] = SIZE_MAX;
+		settled[i] = 0;
+	}
+	if (!queuePrepare(queue, grid->cityCount, maxLength)) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	distance[source] = 0;
+	year[source] = INT16_MAX;
+	queueUpdate(queue, (City *) (stubs + source), source, 0, INT16_MAX);
+	while (!queueEmpty(queue)) {
+		size_t d;
+		int minYear;
+		size_t city = (size_t) ((char *) queuePop(queue, &d, &minYear) - stubs);
+		settled[city] = 1;
+		ans += d;
+		for (size_t i = grid->first[city]; i < grid->first[city + 1]; ++i) {
+			size_t next = grid->targets[i];
+			if (settled[next])
+				continue;
+			size_t nextDistance = d + grid->lengths[i];
+			int nextYear = (minYear < grid->years[i] ? minYear : grid->years[i]);
+			if (nextDistance < distance[next] || (nextDistance == distance[next] && nextYear > year[next])) {
+				distance[next] = nextDistance;
+				year[next] = nextYear;
+				queueUpdate(queue, (City *) (stubs + next), next, nextDistance, nextYear);
+			}
+		}
+	}
+	return ans;
+}
+
+static double run(Heap *queue, const Grid *grid, unsigned maxLength, size_t searches, uint64_t *checksum) {
+	size_t *distance = malloc(grid->cityCount * sizeof(size_t));
+	int *year = malloc(grid->cityCount * sizeof(int));
+	unsigned char *settled = malloc(grid->cityCount);
+	if (!distance || !year || !settled) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	srand(1);
+	*checksum = 0;
+	clock_t start = clock();
+	for (size_t i = 0; i < searches; ++i) {
+		size_t source = (size_t) rand() % grid->cityCount;
+		*checksum += search(queue, grid, source, maxLength, distance, year, settled);
+	}
+	clock_t end = clock();
+	free(distance);
+	free(year);
+	free(settled);
+	return 1000.0 * (double) (end - start) / CLOCKS_PER_SEC / (double) searches;
+}
+//! @endcond
+
+/** @brief Runs the benchmark.
+ * @param[in] argc number of arguments
+ * @param[in] argv side of the grid and number of searches, both optional
+ * @return 0 if both engines agreed on all distances, 1 otherwise
+ */
+int main(int argc, char **argv) {
+	const size_t side = (argc > 1 ? strtoul(argv[1], NULL, 10) : 400);
+	const size_t searches = (argc > 2 ? strtoul(argv[2], NULL, 10) : 10);
+	const Distribution distributions[] = {
+			{"uniform 1-10", drawShort},
+			{"uniform 1-100", drawMedium},
+			{"uniform 1-1000", drawLong},
+			{"mixed 1-20/200-1000", drawMixed},
+			{"uniform 1-100000", drawHuge},
+	};
+	int ans = 0;
+	Heap *queue = queueInit();
+	stubs = malloc(side * side);
+	if (!queue || !stubs || side == 0 || searches == 0) {
+		fprintf(stderr, "usage: %s [side] [searches]\n", argv[0]);
+		return 1;
+	}
+	printf("%zu cities, %zu searches settling all of them\n", side * side, searches);
+	printf("%-22s %12s %12s %9s\n", "road lengths", "heap [ms]", "buckets [ms]", "speedup");
+	for (size_t i = 0; i < sizeof(distributions) / sizeof(distributions[0]); ++i) {
+		srand(42);
+		Grid grid = makeGrid(side, distributions[i].draw);
+		uint64_t heapSum, bucketSum;
+		double heapTime = run(queue, &grid, UINT32_MAX, searches, &heapSum);
+		double bucketTime = run(queue, &grid, grid.longest, searches, &bucketSum);
+		printf("%-22s %12.2f ", distributions[i].name, heapTime);
+		if (grid.longest > QUEUE_BUCKET_LIMIT)
+			printf("%12s %9s\n", "(heap)", "-");
+		else
+			printf("%12.2f %8.2fx\n", bucketTime, heapTime / bucketTime);
+		if (heapSum != bucketSum) {
+			printf("  distances differ between the engines\n");
+			ans = 1;
+		}
+		freeGrid(&grid);
+	}
+	free(stubs);
+	queueDestroy(&queue);
+	return ans;
+}
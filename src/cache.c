@@ -0,0 +1,197 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "cache.h"
+#include "exclusion.h"
+#include "hash.h"
+
+#define CACHE_SIZE 1024
+
+/// A result stored in the cache.
+typedef struct CacheEntry CacheEntry;
+
+/** Results of recent path searches.
+ * A result is stored under the ends of the path and a fingerprint of what
+ * the search excluded, in a slot chosen by these; a new result replaces the
+ * one in its slot. Fingerprints may collide, so a result also keeps what
+ * was excluded and is only used by a search excluding the same.
+ * The map changes in two ways: added or removed roads change the lengths of
+ * paths, so all results become invalid, while repairs only change years.
+ * The years only matter if there are several shortest paths, so a result
+ * with a single shortest path, or with no path at all, remains valid after
+ * repairs. Instead of clearing the results, the cache counts the changes of
+ * both kinds and a result is valid only if it was stored after the last
+ * change that affects it.
+ */
+struct Cache {
+	/// the stored results, CACHE_SIZE of them
+	CacheEntry *entries;
+	/// number of results found in the cache
+	size_t hits;
+	/// number of results not found in the cache
+	size_t misses;
+	/// number of changes of the roads, never 0
+	unsigned topology;
+	/// number of changes of the years, never 0
+	unsigned years;
+};
+
+//! @cond
+struct CacheEntry {
+	/// the path, NULL if there is none
+	Road **roads;
+	/// the first city of the path
+	const City *from;
+	/// the last city of the path
+	const City *to;
+	/// fingerprint of the cities and the road excluded from the search
+	uint64_t fingerprint;
+	/// the road excluded from the search, NULL if there was none
+	const Road *road;
+	/// ids of the cities excluded from the search, NULL if there were none
+	size_t *cityIds;
+	/// number of cities excluded from the search
+	size_t blocked;
+	/// number of roads in the path, SIZE_MAX if there is no unique path
+	size_t length;
+	/// the number of changes of the roads when the result was stored, 0 if none was
+	unsigned topology;
+	/// the number of changes of the years when the result was stored
+	unsigned years;
+	/// true if there are several shortest paths
+	bool tied;
+};
+
+static bool isValid(const Cache *cache, const CacheEntry *entry);
+static void clear(Cache *cache);
+static void release(CacheEntry *entry);
+static CacheEntry *slot(const Cache *cache, const City *from, const City *to, uint64_t fingerprint);
+//! @endcond
+
+Cache *cacheInit(void) {
+	Cache *ans = malloc(sizeof(Cache));
+	if (ans) {
+		*ans = (Cache) {
+			.hits = 0,
+			.misses = 0,
+			.topology = 1,
+			.years = 1,
+			.entries = calloc(CACHE_SIZE, sizeof(CacheEntry)),
+		};
+		if (ans->entries)
+			return ans;
+		free(ans);
+	}
+	return NULL;
+}
+
+void cacheDestroy(Cache **pCache) {
+	Cache *cache = *pCache;
+	clear(cache);
+	free(cache->entries);
+	free(cache);
+	*pCache = NULL;
+}
+
+bool cacheFind(Cache *cache, const City *from, const City *to, const Exclusion *exclusion, Road ***pRoads, size_t *length) {
+	const uint64_t fingerprint = exclusionFingerprint(exclusion);
+	const CacheEntry *entry = slot(cache, from, to, fingerprint);
+	if (!isValid(cache, entry) || entry->from != from || entry->to != to || entry->fingerprint != fingerprint
+			|| !exclusionSame(exclusion, entry->road, entry->cityIds, entry->blocked)) {
+		++cache->misses;
+		return false;
+	}
+	Road **roads = NULL;
+	if (entry->roads) {
+		roads = malloc(entry->length * sizeof(Road *));
+		if (roads == NULL) {
+			++cache->misses;
+			return false;
+		}
+		memcpy(roads, entry->roads, entry->length * sizeof(Road *));
+	}
+	++cache->hits;
+	*pRoads = roads;
+	*length = entry->length;
+	return true;
+}
+
+// the result isn't stored if there is no memory for it
+void cacheStore(Cache *cache, const City *from, const City *to, const Exclusion *exclusion,
+		Road *const *roads, size_t length, bool tied) {
+	size_t blocked;
+	const size_t *cityIds = exclusionCities(exclusion, &blocked);
+	const uint64_t fingerprint = exclusionFingerprint(exclusion);
+	CacheEntry *entry = slot(cache, from, to, fingerprint);
+	release(entry);
+	if (roads) {
+		entry->roads = malloc(length * sizeof(Road *));
+		if (entry->roads == NULL)
+			return;
+		memcpy(entry->roads, roads, length * sizeof(Road *));
+	}
+	if (blocked > 0) {
+		entry->cityIds = malloc(blocked * sizeof(size_t));
+		if (entry->cityIds == NULL) {
+			release(entry);
+			return;
+		}
+		memcpy(entry->cityIds, cityIds, blocked * sizeof(size_t));
+	}
+	entry->from = from;
+	entry->to = to;
+	entry->fingerprint = fingerprint;
+	entry->road = exclusionRoad(exclusion);
+	entry->blocked = blocked;
+	entry->length = length;
+	entry->topology = cache->topology;
+	entry->years = cache->years;
+	entry->tied = tied;
+}
+
+// the counters start over when they wrap, results stored before are dropped
+void cacheNoteTopology(Cache *cache) {
+	if (++cache->topology == 0) {
+		clear(cache);
+		cache->topology = 1;
+	}
+}
+
+void cacheNoteYears(Cache *cache) {
+	if (++cache->years == 0) {
+		clear(cache);
+		cache->years = 1;
+	}
+}
+
+void cacheStatistics(const Cache *cache, size_t *hits, size_t *misses) {
+	*hits = cache->hits;
+	*misses = cache->misses;
+}
+
+//! @cond
+static bool isValid(const Cache *cache, const CacheEntry *entry) {
+	if (entry->topology != cache->topology)
+		return false;
+	return !entry->tied || entry->years == cache->years;
+}
+
+static void clear(Cache *cache) {
+	for (size_t i = 0; i < CACHE_SIZE; ++i)
+		release(&cache->entries[i]);
+}
+
+// the entry becomes invalid
+static void release(CacheEntry *entry) {
+	free(entry->roads);
+	free(entry->cityIds);
+	entry->roads = NULL;
+	entry->cityIds = NULL;
+	entry->topology = 0;
+}
+
+static CacheEntry *slot(const Cache *cache, const City *from, const City *to, uint64_t fingerprint) {
+	const uint64_t hash = hashMix((uintptr_t) from + hashMix((uintptr_t) to + hashMix(fingerprint)));
+	return &cache->entries[hash % CACHE_SIZE];
+}
+//! @endcond
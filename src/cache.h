@@ -0,0 +1,27 @@
+/** @file
+ * Interface for a cache of path search results, valid until the map changes.
+ */
+
+#ifndef MAP_CACHE_H
+#define MAP_CACHE_H
+
+#include <stdbool.h>
+#include "global_declarations.h"
+
+/// find a result stored for the same excluded cities and road, the path is copied; false if there is none
+bool cacheFind(Cache *cache, const City *from, const City *to, const Exclusion *exclusion, Road ***pRoads, size_t *length);
+/// take into account roads added or removed, all results become invalid
+void cacheNoteTopology(Cache *cache);
+/// take into account a repaired road, only results chosen by years become invalid
+void cacheNoteYears(Cache *cache);
+/// get the number of results found and not found in the cache
+void cacheStatistics(const Cache *cache, size_t *hits, size_t *misses);
+/// store a copy of a result and of what was excluded, tied if the path was chosen among others by years
+void cacheStore(Cache *cache, const City *from, const City *to, const Exclusion *exclusion,
+		Road *const *roads, size_t length, bool tied);
+/// destroy the cache
+void cacheDestroy(Cache **pCache);
+/// create an empty cache
+Cache *cacheInit(void);
+
+#endif //MAP_CACHE_H
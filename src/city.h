@@ -36,21 +36,23 @@ size_t cityCopyName(char *dest, const City *city);
 size_t cityGetNameLength(const City *city);
 /// return the number of roads in the city
 size_t cityGetRoadCount(const City *city);
-/// make the city inaccessible when searching for paths
-void cityBlock(City *city);
+/// get the id of a city
+size_t cityGetId(const City *city);
+/// get a road connected to the city
+Road *cityGetRoad(const City *city, size_t index);
+/// find the other end of a road leading out of the city
+City *cityNeighbour(const City *city, size_t index);
+/// change the id of a city
+void citySetId(City *city, size_t id);
 /// destroy the city
 void cityDestroy(City **pCity);
 /// detach the road from the city
 void cityDetach(City *city, const Road *road);
 /// detach the last road from a city
 void cityDetachLast(City *city);
-/// make the city accessible again
-void cityUnblock(City *city);
 /// add a city to the map
 City *cityAdd(CityMap *cityMap, const char *name, Road *road);
 /// create a decoy city
 City *cityDecoy(void);
-/// find a path between two cities
-Road **cityPath(City *from, City *to, CityMap *cityMap, size_t *length);
 
 #endif //MAP_CITY_H
@@ -24,6 +24,8 @@ struct CityMap {
 
 static bool adjust(CityMap *cityMap);
 static bool empty(const CityMap *cityMap);
+static int compareDegree(const void *lhs, const void *rhs);
+static size_t visitComponent(City **order, size_t tail, bool *seen);
 static void destroyLast(CityMap *cityMap);
 
 CityMap *cityMapInit() {
@@ -71,7 +73,50 @@ City *cityMapAddCity(CityInfo info, City *(*fun)(CityInfo, size_t)) {
 	return NULL;
 }
 
-City *const *cityMapSuffix(CityMap *cityMap, size_t start) {
+/* Reverse Cuthill-McKee: every connected component is traversed breadth
+ * first, starting from a city of the smallest degree and queueing the
+ * neighbours of each city by increasing degree. Reversing the resulting
+ * sequence gives the new ids.
+ */
+bool cityMapReorder(CityMap *cityMap) {
+	const size_t n = cityMap->length;
+	if (n == 0)
+		return true;
+	City **byDegree = malloc(n * sizeof(City *));
+	if (byDegree) {
+		City **order = malloc(n * sizeof(City *));
+		if (order) {
+			bool *seen = calloc(n, sizeof(bool));
+			if (seen) {
+				size_t tail = 0;
+				memcpy(byDegree, cityMap->cities, n * sizeof(City *));
+				qsort(byDegree, n, sizeof(City *), compareDegree);
+				for (size_t i = 0; i < n; ++i) {
+					size_t id = cityGetId(byDegree[i]);
+					if (seen[id])
+						continue;
+					seen[id] = true;
+					order[tail] = byDegree[i];
+					tail = visitComponent(order, tail, seen);
+				}
+				assert(tail == n);
+				for (size_t i = 0; i < n; ++i) {
+					cityMap->cities[i] = order[n - 1 - i];
+					citySetId(cityMap->cities[i], i);
+				}
+				free(seen);
+				free(order);
+				free(byDegree);
+				return true;
+			}
+			free(order);
+		}
+		free(byDegree);
+	}
+	return false;
+}
+
+City *const *cityMapSuffix(const CityMap *cityMap, size_t start) {
 	assert(start < cityMapGetLength(cityMap));
 	return &cityMap->cities[start];
 }
@@ -88,6 +133,8 @@ bool cityMapTest(const CityMap *cityMap, Trie *trie) {
 	for (size_t i = 0; i < cityMap->length; ++i) {
 		City *city = cityMap->cities[i];
 		assert(city);
+		if (cityGetId(city) != i)
+			return false;
 		if (trieFind(trie, cityGetName(city)) != city)
 			return false;
 	}
@@ -106,6 +153,36 @@ static void destroyLast(CityMap *cityMap) {
 	--cityMap->length;
 }
 
+// order cities by degree, then by their current id
+static int compareDegree(const void *lhs, const void *rhs) {
+	const City *city1 = *(City *const *) lhs, *city2 = *(City *const *) rhs;
+	size_t degree1 = cityGetRoadCount(city1), degree2 = cityGetRoadCount(city2);
+	if (degree1 != degree2)
+		return degree1 < degree2 ? -1 : 1;
+	return cityGetId(city1) < cityGetId(city2) ? -1 : 1;
+}
+
+/* breadth first search from order[tail], appends the cities reached to order
+ * and returns the new number of cities in it
+ */
+static size_t visitComponent(City **order, size_t tail, bool *seen) {
+	size_t head = tail++;
+	for (; head < tail; ++head) {
+		City *city = order[head];
+		const size_t start = tail;
+		for (size_t i = 0; i < cityGetRoadCount(city); ++i) {
+			City *next = cityNeighbour(city, i);
+			if (seen[cityGetId(next)])
+				continue;
+			seen[cityGetId(next)] = true;
+			order[tail] = next;
+			++tail;
+		}
+		qsort(order + start, tail - start, sizeof(City *), compareDegree);
+	}
+	return tail;
+}
+
 static bool empty(const CityMap *cityMap) {
 	return cityMap->length == 0;
 }
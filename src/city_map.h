@@ -10,6 +10,8 @@
 
 /// debug function, check invariants in a CityMap structure
 bool cityMapTest(const CityMap *cityMap, Trie *trie);
+/// renumber the cities so that neighbouring cities get close ids
+bool cityMapReorder(CityMap *cityMap);
 /// get the length of the city map
 size_t cityMapGetLength(const CityMap *cityMap);
 /// destroy the structure
@@ -19,7 +21,7 @@ void cityMapTrim(CityMap *cityMap, size_t length);
 /// add a city to the map
 City *cityMapAddCity(CityInfo info, City *(*fun)(CityInfo, size_t));
 /// get the suffix of the list of a given length
-City *const *cityMapSuffix(CityMap *cityMap, size_t start);
+City *const *cityMapSuffix(const CityMap *cityMap, size_t start);
 /// create a CityMap structure
 CityMap *cityMapInit(void);
 
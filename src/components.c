@@ -0,0 +1,231 @@
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "city.h"
+#include "city_map.h"
+#include "components.h"
+#include "road.h"
+
+#define CHECK_LIMIT 256
+#define INIT_SPACE 8
+
+/** The connected parts of the road map, as a union-find forest of city ids.
+ * A new road joins the trees of its ends. A removed road may split a part,
+ * which a forest can't undo. A search from both ends of the road, limited to
+ * CHECK_LIMIT cities on each side, tells if they stay connected; if they
+ * don't, or the search can't tell, the forest is marked as stale and built
+ * again from all roads of the map the next time it is asked. Renumbering
+ * the cities goes through all roads anyway, so it marks the forest as stale
+ * as well. Cities with
+ * ids the forest has no place for yet have no roads in it, so each of them
+ * is a part of its own. A forest that lost track of the map only ever joins
+ * too much, so it can say two cities may be connected when they aren't,
+ * but never the other way around.
+ */
+struct Components {
+	/// the parent of each city in its tree, itself for the root, by city id
+	size_t *parents;
+	/// an upper bound on the height of the tree of each root, by city id
+	unsigned char *ranks;
+	/// twice the generation of the check reaching a city plus its side, by city id
+	unsigned *marks;
+	/// number of cities with a place in the forest
+	size_t length;
+	/// number of cities the forest has space for
+	size_t capacity;
+	/// the generation of the last check of a removed road
+	unsigned generation;
+	/// true if the forest has to be built again before it is used
+	bool stale;
+};
+
+//! @cond
+static bool adjust(Components *components, size_t cityCount);
+static bool bypassed(Components *components, Road *road);
+static bool rebuild(Components *components, const CityMap *cityMap);
+static size_t root(Components *components, size_t cityId);
+static void join(Components *components, size_t cityId1, size_t cityId2);
+//! @endcond
+
+// a new forest knows nothing of the map, so it is built at first use
+Components *componentsInit(void) {
+	Components *ans = malloc(sizeof(Components));
+	if (ans) {
+		*ans = (Components) {
+			.length = 0,
+			.capacity = INIT_SPACE,
+			.generation = 0,
+			.stale = true,
+			.parents = malloc(INIT_SPACE * sizeof(size_t)),
+			.ranks = malloc(INIT_SPACE * sizeof(unsigned char)),
+			.marks = calloc(INIT_SPACE, sizeof(unsigned)),
+		};
+		if (ans->parents && ans->ranks && ans->marks)
+			return ans;
+		free(ans->parents);
+		free(ans->ranks);
+		free(ans->marks);
+		free(ans);
+	}
+	return NULL;
+}
+
+void componentsDestroy(Components **pComponents) {
+	Components *components = *pComponents;
+	free(components->parents);
+	free(components->ranks);
+	free(components->marks);
+	free(components);
+	*pComponents = NULL;
+}
+
+// a road that can't be recorded leaves the forest to be built again
+void componentsNoteRoad(Components *components, Road *road) {
+	City *city1, *city2;
+	if (components->stale)
+		return;
+	roadGetCities(road, &city1, &city2);
+	const size_t id1 = cityGetId(city1), id2 = cityGetId(city2);
+	if (!adjust(components, (id1 > id2 ? id1 : id2) + 1)) {
+		components->stale = true;
+		return;
+	}
+	join(components, id1, id2);
+}
+
+// the road is still attached to its cities, the search doesn't use it
+void componentsNoteRemoval(Components *components, Road *road) {
+	if (!components->stale && !bypassed(components, road))
+		components->stale = true;
+}
+
+void componentsNoteChange(Components *components) {
+	components->stale = true;
+}
+
+// a forest that can't be built says the cities may be connected
+bool componentsConnected(Components *components, const CityMap *cityMap, const City *city1, const City *city2) {
+	if (city1 == city2)
+		return true;
+	if (components->stale && !rebuild(components, cityMap))
+		return true;
+	const size_t id1 = cityGetId(city1), id2 = cityGetId(city2);
+	if (id1 >= components->length || id2 >= components->length)
+		return false;
+	return root(components, id1) == root(components, id2);
+}
+
+//! @cond
+// new cities start as parts of their own
+static bool adjust(Components *components, size_t cityCount) {
+	if (cityCount > components->capacity) {
+		size_t newCapacity = components->capacity;
+		while (newCapacity < cityCount)
+			newCapacity *= 2;
+		size_t *parents = realloc(components->parents, newCapacity * sizeof(size_t));
+		if (parents == NULL)
+			return false;
+		components->parents = parents;
+		unsigned char *ranks = realloc(components->ranks, newCapacity * sizeof(unsigned char));
+		if (ranks == NULL)
+			return false;
+		components->ranks = ranks;
+		unsigned *marks = realloc(components->marks, newCapacity * sizeof(unsigned));
+		if (marks == NULL)
+			return false;
+		memset(marks + components->capacity, 0, (newCapacity - components->capacity) * sizeof(unsigned));
+		components->marks = marks;
+		components->capacity = newCapacity;
+	}
+	for (size_t i = components->length; i < cityCount; ++i) {
+		components->parents[i] = i;
+		components->ranks[i] = 0;
+	}
+	if (cityCount > components->length)
+		components->length = cityCount;
+	return true;
+}
+
+/* searches from both ends of the road at once, a city at a time from the
+ * side that reached fewer; true if the sides meet, false if one of them
+ * runs out of cities or reaches too many of them
+ */
+static bool bypassed(Components *components, Road *road) {
+	City *queues[2][CHECK_LIMIT];
+	size_t heads[2] = {0, 0}, tails[2] = {1, 1};
+	roadGetCities(road, &queues[0][0], &queues[1][0]);
+	const size_t id1 = cityGetId(queues[0][0]), id2 = cityGetId(queues[1][0]);
+	if (!adjust(components, (id1 > id2 ? id1 : id2) + 1))
+		return false;
+	if (++components->generation > UINT_MAX / 2) {
+		memset(components->marks, 0, components->capacity * sizeof(unsigned));
+		components->generation = 1;
+	}
+	const unsigned base = 2 * components->generation;
+	components->marks[id1] = base;
+	components->marks[id2] = base + 1;
+	while (heads[0] < tails[0] && heads[1] < tails[1]) {
+		const size_t side = (tails[0] <= tails[1] ? 0 : 1);
+		City *city = queues[side][heads[side]++];
+		const size_t roadCount = cityGetRoadCount(city);
+		for (size_t i = 0; i < roadCount; ++i) {
+			if (cityGetRoad(city, i) == road)
+				continue;
+			City *next = cityNeighbour(city, i);
+			const size_t nextId = cityGetId(next);
+			if (nextId >= components->length)
+				return false;
+			if (components->marks[nextId] == base + 1 - side)
+				return true;
+			if (components->marks[nextId] == base + side)
+				continue;
+			if (tails[side] == CHECK_LIMIT)
+				return false;
+			components->marks[nextId] = (unsigned) (base + side);
+			queues[side][tails[side]++] = next;
+		}
+	}
+	return false;
+}
+
+static bool rebuild(Components *components, const CityMap *cityMap) {
+	const size_t cityCount = cityMapGetLength(cityMap);
+	components->length = 0;
+	if (!adjust(components, cityCount))
+		return false;
+	City *const *cities = (cityCount > 0 ? cityMapSuffix(cityMap, 0) : NULL);
+	for (size_t i = 0; i < cityCount; ++i) {
+		const size_t roadCount = cityGetRoadCount(cities[i]);
+		for (size_t j = 0; j < roadCount; ++j)
+			join(components, i, cityGetId(cityNeighbour(cities[i], j)));
+	}
+	components->stale = false;
+	return true;
+}
+
+// halves the path to the root on the way
+static size_t root(Components *components, size_t cityId) {
+	size_t *parents = components->parents;
+	while (parents[cityId] != cityId) {
+		parents[cityId] = parents[parents[cityId]];
+		cityId = parents[cityId];
+	}
+	return cityId;
+}
+
+static void join(Components *components, size_t cityId1, size_t cityId2) {
+	size_t root1 = root(components, cityId1), root2 = root(components, cityId2);
+	if (root1 == root2)
+		return;
+	if (components->ranks[root1] < components->ranks[root2]) {
+		const size_t tmp = root1;
+		root1 = root2;
+		root2 = tmp;
+	}
+	components->parents[root2] = root1;
+	if (components->ranks[root1] == components->ranks[root2])
+		++components->ranks[root1];
+}
+//! @endcond
@@ -0,0 +1,24 @@
+/** @file
+ * Interface for an index of the connected parts of the road map.
+ */
+
+#ifndef MAP_COMPONENTS_H
+#define MAP_COMPONENTS_H
+
+#include <stdbool.h>
+#include "global_declarations.h"
+
+/// check if two cities may be connected by roads, false only if they surely aren't
+bool componentsConnected(Components *components, const CityMap *cityMap, const City *city1, const City *city2);
+/// destroy the structure
+void componentsDestroy(Components **pComponents);
+/// take into account a road added to the map
+void componentsNoteRoad(Components *components, Road *road);
+/// take into account a road about to be removed from the map
+void componentsNoteRemoval(Components *components, Road *road);
+/// take into account new ids of the cities
+void componentsNoteChange(Components *components);
+/// create an index that is built at first use
+Components *componentsInit(void);
+
+#endif //MAP_COMPONENTS_H
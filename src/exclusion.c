@@ -0,0 +1,178 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "city.h"
+#include "exclusion.h"
+#include "hash.h"
+
+#define INIT_SPACE 8
+
+/** Cities and a road that a single path search may not use.
+ * A city is excluded when its stamp equals the current generation, so
+ * starting a new query only needs to change the generation. The ids of the
+ * excluded cities are also listed, in no particular order. The fingerprint
+ * of the excluded cities is a sum of hashes of their ids, so it can be
+ * updated as they are blocked and unblocked in any order.
+ */
+struct Exclusion {
+	/// the generation of the current query, never 0 after a reset
+	unsigned generation;
+	/// explicit struct padding
+	unsigned pad;
+	/// number of cities excluded from the current query
+	size_t blocked;
+	/// sum of the hashes of the ids of the excluded cities
+	uint64_t fingerprint;
+	/// number of records available in stamps
+	size_t length;
+	/// generation stamps, indexed by city id
+	unsigned *stamps;
+	/// ids of the excluded cities, blocked of them
+	size_t *cities;
+	/// positions of the ids of excluded cities in cities, indexed by city id
+	size_t *slots;
+	/// the road excluded from the current query, NULL if there is none
+	const Road *road;
+};
+
+//! @cond
+static bool adjust(Exclusion *exclusion, size_t cityCount);
+//! @endcond
+
+Exclusion *exclusionInit(void) {
+	Exclusion *ans = malloc(sizeof(Exclusion));
+	if (ans) {
+		*ans = (Exclusion) {
+			.generation = 0,
+			.blocked = 0,
+			.fingerprint = 0,
+			.length = INIT_SPACE,
+			.stamps = calloc(INIT_SPACE, sizeof(unsigned)),
+			.cities = malloc(INIT_SPACE * sizeof(size_t)),
+			.slots = malloc(INIT_SPACE * sizeof(size_t)),
+			.road = NULL,
+		};
+		if (ans->stamps && ans->cities && ans->slots)
+			return ans;
+		free(ans->stamps);
+		free(ans->cities);
+		free(ans->slots);
+		free(ans);
+	}
+	return NULL;
+}
+
+void exclusionDestroy(Exclusion **pExclusion) {
+	Exclusion *exclusion = *pExclusion;
+	free(exclusion->stamps);
+	free(exclusion->cities);
+	free(exclusion->slots);
+	free(exclusion);
+	*pExclusion = NULL;
+}
+
+bool exclusionReset(Exclusion *exclusion, size_t cityCount) {
+	if (!adjust(exclusion, cityCount))
+		return false;
+	if (exclusion->generation == (unsigned) -1) {
+		memset(exclusion->stamps, 0, exclusion->length * sizeof(unsigned));
+		exclusion->generation = 0;
+	}
+	++exclusion->generation;
+	exclusion->blocked = 0;
+	exclusion->fingerprint = 0;
+	exclusion->road = NULL;
+	return true;
+}
+
+bool exclusionHasCity(const Exclusion *exclusion, size_t cityId) {
+	assert(cityId < exclusion->length);
+	return exclusion->stamps[cityId] == exclusion->generation;
+}
+
+bool exclusionHasRoad(const Exclusion *exclusion, const Road *road) {
+	return exclusion->road == road;
+}
+
+bool exclusionSame(const Exclusion *exclusion, const Road *road, const size_t *cityIds, size_t count) {
+	if (exclusion->road != road || exclusion->blocked != count)
+		return false;
+	for (size_t i = 0; i < count; ++i) {
+		if (cityIds[i] >= exclusion->length || !exclusionHasCity(exclusion, cityIds[i]))
+			return false;
+	}
+	return true;
+}
+
+bool exclusionEmpty(const Exclusion *exclusion) {
+	return exclusion->blocked == 0 && exclusion->road == NULL;
+}
+
+const size_t *exclusionCities(const Exclusion *exclusion, size_t *count) {
+	*count = exclusion->blocked;
+	return exclusion->cities;
+}
+
+const Road *exclusionRoad(const Exclusion *exclusion) {
+	return exclusion->road;
+}
+
+// different sets of excluded cities and roads have different fingerprints, barring collisions
+uint64_t exclusionFingerprint(const Exclusion *exclusion) {
+	return exclusion->fingerprint + hashMix(exclusion->blocked) + hashMix((uintptr_t) exclusion->road);
+}
+
+void exclusionBlock(Exclusion *exclusion, const City *city) {
+	size_t id = cityGetId(city);
+	assert(id < exclusion->length);
+	if (exclusion->stamps[id] != exclusion->generation) {
+		exclusion->slots[id] = exclusion->blocked;
+		exclusion->cities[exclusion->blocked++] = id;
+		exclusion->fingerprint += hashMix(id + 1);
+	}
+	exclusion->stamps[id] = exclusion->generation;
+}
+
+void exclusionUnblock(Exclusion *exclusion, const City *city) {
+	size_t id = cityGetId(city);
+	assert(id < exclusion->length);
+	if (exclusion->stamps[id] == exclusion->generation) {
+		size_t last = exclusion->cities[--exclusion->blocked];
+		exclusion->cities[exclusion->slots[id]] = last;
+		exclusion->slots[last] = exclusion->slots[id];
+		exclusion->fingerprint -= hashMix(id + 1);
+	}
+	exclusion->stamps[id] = 0;
+}
+
+void exclusionBlockRoad(Exclusion *exclusion, const Road *road) {
+	assert(exclusion->road == NULL);
+	exclusion->road = road;
+}
+
+//! @cond
+static bool adjust(Exclusion *exclusion, size_t cityCount) {
+	if (cityCount <= exclusion->length)
+		return true;
+	size_t newLength = exclusion->length;
+	while (newLength < cityCount)
+		newLength *= 2;
+	size_t *cities = realloc(exclusion->cities, newLength * sizeof(size_t));
+	if (cities == NULL)
+		return false;
+	exclusion->cities = cities;
+	size_t *slots = realloc(exclusion->slots, newLength * sizeof(size_t));
+	if (slots == NULL)
+		return false;
+	exclusion->slots = slots;
+	unsigned *tmp = realloc(exclusion->stamps, newLength * sizeof(unsigned));
+	if (tmp == NULL)
+		return false;
+	memset(tmp + exclusion->length, 0, (newLength - exclusion->length) * sizeof(unsigned));
+	exclusion->stamps = tmp;
+	exclusion->length = newLength;
+	return true;
+}
+//! @endcond
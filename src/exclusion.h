@@ -0,0 +1,38 @@
+/** @file
+ * Interface for a per-query set of cities and roads excluded from searches.
+ */
+
+#ifndef MAP_EXCLUSION_H
+#define MAP_EXCLUSION_H
+
+#include <stdbool.h>
+#include "global_declarations.h"
+
+/// check if a city with a given id can't be visited by the current query
+bool exclusionHasCity(const Exclusion *exclusion, size_t cityId);
+/// check if a road can't be used by the current query
+bool exclusionHasRoad(const Exclusion *exclusion, const Road *road);
+/// check if nothing is excluded from the current query
+bool exclusionEmpty(const Exclusion *exclusion);
+/// check if exactly the given road and cities are excluded from the current query
+bool exclusionSame(const Exclusion *exclusion, const Road *road, const size_t *cityIds, size_t count);
+/// get the ids of the cities excluded from the current query, in no particular order
+const size_t *exclusionCities(const Exclusion *exclusion, size_t *count);
+/// get the road excluded from the current query, NULL if there is none
+const Road *exclusionRoad(const Exclusion *exclusion);
+/// get a fingerprint of what is excluded from the current query
+uint64_t exclusionFingerprint(const Exclusion *exclusion);
+/// start a new query with nothing excluded, make space for all cities
+bool exclusionReset(Exclusion *exclusion, size_t cityCount);
+/// make the city inaccessible for the current query
+void exclusionBlock(Exclusion *exclusion, const City *city);
+/// make the road inaccessible for the current query
+void exclusionBlockRoad(Exclusion *exclusion, const Road *road);
+/// destroy the structure
+void exclusionDestroy(Exclusion **pExclusion);
+/// make the city accessible again
+void exclusionUnblock(Exclusion *exclusion, const City *city);
+/// create an empty Exclusion structure
+Exclusion *exclusionInit(void);
+
+#endif //MAP_EXCLUSION_H
@@ -5,24 +5,34 @@
 #ifndef MAP_GLOBAL_DECLARATIONS_H
 #define MAP_GLOBAL_DECLARATIONS_H
 
-/// all route ids must be lower than this
-#define ROUTE_LIMIT 1000
-
 #include <assert.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
 
 //! @cond
+typedef struct Cache Cache;
 typedef struct City City;
+typedef struct CityDistance CityDistance;
 typedef struct CityInfo CityInfo;
 typedef struct CityMap CityMap;
+typedef struct Components Components;
+typedef struct Exclusion Exclusion;
 typedef struct Heap Heap;
+typedef struct Landmarks Landmarks;
 typedef struct NameList NameList;
 typedef struct Map Map;
+typedef struct MapQuery MapQuery;
+typedef struct Overlay Overlay;
+typedef struct Pool Pool;
+typedef struct Positions Positions;
 typedef struct Road Road;
 typedef struct RoadMap RoadMap;
 typedef struct RoadInfo RoadInfo;
+typedef struct RouteSet RouteSet;
+typedef struct RouteTable RouteTable;
+typedef struct Search Search;
 typedef struct Trie Trie;
 typedef struct Trunk Trunk;
 //! @endcond
@@ -35,6 +45,16 @@ struct NameList {
 	size_t length;
 };
 
+/// The best paths from one city to another, as found by a search of the whole map.
+struct CityDistance {
+	/// length of the shortest paths, SIZE_MAX if there are none
+	size_t distance;
+	/// the highest minimum year of the roads among the shortest paths
+	int year;
+	/// true if no other shortest path has the same minimum year
+	bool unique;
+};
+
 //! @cond
 struct RoadInfo {
 	const char *city1, *city2;
@@ -0,0 +1,17 @@
+/** @file
+ * A mixing function shared by the fingerprints and the hash tables.
+ */
+
+#ifndef MAP_HASH_H
+#define MAP_HASH_H
+
+#include <stdint.h>
+
+/// scramble the bits of a number, so that close numbers give distant hashes
+static inline uint64_t hashMix(uint64_t x) {
+	x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+	x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+	return x ^ (x >> 31);
+}
+
+#endif //MAP_HASH_H
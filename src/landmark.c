@@ -0,0 +1,198 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "city.h"
+#include "city_map.h"
+#include "landmark.h"
+#include "queue.h"
+#include "road.h"
+
+#define INIT_SPACE 8
+#define UNREACHABLE SIZE_MAX
+
+/** Distances from a few cities, the landmarks, to all others.
+ * The distances to a landmark differ between the ends of a road by no more
+ * than its length, so for any two cities the difference of their distances
+ * is a lower bound on the length of a path between them. The bound remains
+ * a lower bound when roads are removed or excluded from a search; a new road
+ * can make some distances shorter, these are updated when it is added.
+ */
+struct Landmarks {
+	/// distances from the landmarks, those of a single city are adjacent
+	size_t *distances;
+	/// the queue used to find distances, kept to avoid reallocating it
+	Heap *queue;
+	/// number of cities with distances available
+	size_t length;
+	/// number of landmarks
+	unsigned count;
+	/// length of the longest road in the map
+	unsigned longest;
+};
+
+//! @cond
+static bool adjust(Landmarks *landmarks, size_t cityCount);
+static bool spread(Landmarks *landmarks, unsigned index, City *city, size_t distance);
+static size_t *at(const Landmarks *landmarks, size_t cityId, unsigned index);
+static size_t farthest(const Landmarks *landmarks, City *const *cities, unsigned chosen, size_t cityCount);
+//! @endcond
+
+Landmarks *landmarksInit(CityMap *cityMap, unsigned count, unsigned longest) {
+	const size_t cityCount = cityMapGetLength(cityMap);
+	assert(count > 0);
+	if (cityCount < count)
+		count = (unsigned) cityCount;
+	if (count == 0)
+		return NULL;
+	Landmarks *ans = malloc(sizeof(Landmarks));
+	if (ans) {
+		*ans = (Landmarks) {
+			.length = 0,
+			.count = count,
+			.longest = longest,
+			.distances = NULL,
+			.queue = queueInit(),
+		};
+		if (ans->queue && adjust(ans, cityCount)) {
+			City *const *cities = cityMapSuffix(cityMap, 0);
+			bool success = true;
+			// the first landmark is the city farthest from an arbitrary one
+			for (unsigned i = 0; success && i <= count; ++i) {
+				const unsigned index = (i > 0 ? i - 1 : 0);
+				const size_t cityId = (i > 0 ? farthest(ans, cities, index, cityCount) : 0);
+				for (size_t j = 0; j < cityCount; ++j)
+					*at(ans, j, index) = UNREACHABLE;
+				success = spread(ans, index, cities[cityId], 0);
+			}
+			if (success)
+				return ans;
+		}
+		landmarksDestroy(&ans);
+	}
+	return NULL;
+}
+
+void landmarksDestroy(Landmarks **pLandmarks) {
+	Landmarks *landmarks = *pLandmarks;
+	if (landmarks->queue)
+		queueDestroy(&landmarks->queue);
+	free(landmarks->distances);
+	free(landmarks);
+	*pLandmarks = NULL;
+}
+
+unsigned landmarksCount(const Landmarks *landmarks) {
+	return landmarks->count;
+}
+
+bool landmarksNoteRoad(Landmarks *landmarks, Road *road) {
+	City *city1, *city2;
+	roadGetCities(road, &city1, &city2);
+	const size_t id1 = cityGetId(city1), id2 = cityGetId(city2);
+	const unsigned length = roadGetLength(road);
+	if (length > landmarks->longest)
+		landmarks->longest = length;
+	if (!adjust(landmarks, (id1 > id2 ? id1 : id2) + 1))
+		return false;
+	for (unsigned i = 0; i < landmarks->count; ++i) {
+		const size_t distance1 = *at(landmarks, id1, i), distance2 = *at(landmarks, id2, i);
+		bool success = true;
+		if (distance1 != UNREACHABLE && distance1 + length < distance2)
+			success = spread(landmarks, i, city2, distance1 + length);
+		else if (distance2 != UNREACHABLE && distance2 + length < distance1)
+			success = spread(landmarks, i, city1, distance2 + length);
+		if (!success)
+			return false;
+	}
+	return true;
+}
+
+// the largest difference of distances to a landmark reaching both cities
+size_t landmarksBound(const Landmarks *landmarks, size_t cityId, size_t targetId) {
+	size_t ans = 0;
+	if (cityId >= landmarks->length || targetId >= landmarks->length)
+		return 0;
+	const size_t *distances1 = at(landmarks, cityId, 0), *distances2 = at(landmarks, targetId, 0);
+	for (unsigned i = 0; i < landmarks->count; ++i) {
+		const size_t distance1 = distances1[i], distance2 = distances2[i];
+		if (distance1 == UNREACHABLE || distance2 == UNREACHABLE)
+			continue;
+		const size_t difference = (distance1 > distance2 ? distance1 - distance2 : distance2 - distance1);
+		if (difference > ans)
+			ans = difference;
+	}
+	return ans;
+}
+
+//! @cond
+static size_t *at(const Landmarks *landmarks, size_t cityId, unsigned index) {
+	assert(cityId < landmarks->length && index < landmarks->count);
+	return &landmarks->distances[cityId * landmarks->count + index];
+}
+
+// cities added since the last call are unreachable from all landmarks
+static bool adjust(Landmarks *landmarks, size_t cityCount) {
+	if (cityCount <= landmarks->length)
+		return true;
+	size_t newLength = (landmarks->length > 0 ? landmarks->length : INIT_SPACE);
+	while (newLength < cityCount)
+		newLength *= 2;
+	size_t *tmp = realloc(landmarks->distances, newLength * landmarks->count * sizeof(size_t));
+	if (tmp == NULL)
+		return false;
+	for (size_t i = landmarks->length * landmarks->count; i < newLength * landmarks->count; ++i)
+		tmp[i] = UNREACHABLE;
+	landmarks->distances = tmp;
+	landmarks->length = newLength;
+	return true;
+}
+
+/* a city not reached by the chosen landmarks is the farthest possible, the
+ * distances of the first landmark are those from an arbitrary city until it
+ * is chosen, cities without roads are of no use
+ */
+static size_t farthest(const Landmarks *landmarks, City *const *cities, unsigned chosen, size_t cityCount) {
+	size_t ans = 0, best = 0;
+	for (size_t i = 0; i < cityCount; ++i) {
+		size_t nearest = *at(landmarks, i, 0);
+		for (unsigned j = 1; j < chosen; ++j) {
+			if (*at(landmarks, i, j) < nearest)
+				nearest = *at(landmarks, i, j);
+		}
+		if (nearest > best && cityGetRoadCount(cities[i]) > 0) {
+			ans = i;
+			best = nearest;
+		}
+	}
+	return ans;
+}
+
+/* lowers the distance of a city to the landmark and passes the change on to
+ * the cities it makes closer, for a new landmark this finds all distances
+ */
+static bool spread(Landmarks *landmarks, unsigned index, City *city, size_t distance) {
+	Heap *queue = landmarks->queue;
+	if (!queuePrepare(queue, landmarks->length, landmarks->longest))
+		return false;
+	queueStart(queue, distance);
+	*at(landmarks, cityGetId(city), index) = distance;
+	queueUpdate(queue, city, cityGetId(city), distance, 0);
+	while (!queueEmpty(queue)) {
+		int year;
+		City *current = queuePop(queue, &distance, &year);
+		const size_t roadCount = cityGetRoadCount(current);
+		for (size_t i = 0; i < roadCount; ++i) {
+			City *nextCity = cityNeighbour(current, i);
+			const size_t nextId = cityGetId(nextCity);
+			const size_t nextDistance = distance + roadGetLength(cityGetRoad(current, i));
+			size_t *record = at(landmarks, nextId, index);
+			if (nextDistance < *record) {
+				*record = nextDistance;
+				queueUpdate(queue, nextCity, nextId, nextDistance, 0);
+			}
+		}
+	}
+	return true;
+}
+//! @endcond
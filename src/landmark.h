@@ -0,0 +1,22 @@
+/** @file
+ * Interface for landmark distances giving lower bounds on path lengths.
+ */
+
+#ifndef MAP_LANDMARK_H
+#define MAP_LANDMARK_H
+
+#include <stdbool.h>
+#include "global_declarations.h"
+
+/// take into account a road added to the map, distances can only get shorter
+bool landmarksNoteRoad(Landmarks *landmarks, Road *road);
+/// get a lower bound on the length of a path between two cities
+size_t landmarksBound(const Landmarks *landmarks, size_t cityId, size_t targetId);
+/// get the number of landmarks
+unsigned landmarksCount(const Landmarks *landmarks);
+/// destroy the structure
+void landmarksDestroy(Landmarks **pLandmarks);
+/// choose landmarks far away from each other and find distances from them
+Landmarks *landmarksInit(CityMap *cityMap, unsigned count, unsigned longest);
+
+#endif //MAP_LANDMARK_H
@@ -1,8 +1,14 @@
+#include <limits.h>
+
 #include "city.h"
 #include "city_map.h"
+#include "exclusion.h"
 #include "map.h"
+#include "map_internal.h"
 #include "queue.h"
 #include "road.h"
+#include "route_table.h"
+#include "search.h"
 #include "trunk.h"
 #include "trie.h"
 
@@ -13,14 +19,39 @@ struct Map {
 	/// a structure storing the roads in the map
 	RoadMap *roads;
 	/// all routes in the map, indexed by id
-	Trunk *routes[ROUTE_LIMIT];
+	RouteTable *routes;
 	/// a structure storing references to cities for fast lookup by name
 	Trie *trie;
+	/// a workspace shared by the path searches of the map
+	Search *search;
+};
+
+/** A query for the best path between two cities, run by steps.
+ * The queries of a map share a workspace of their own. A query is valid as
+ * long as the version of the workspace is the one it began with; a change
+ * of the map or another query begun makes it fail.
+ */
+struct MapQuery {
+	/// the workspace running the query
+	Search *search;
+	/// the version of the workspace when the query began
+	unsigned version;
 };
 
+/// The Routes of a road being removed and the detours found for them.
+typedef struct Rebuild Rebuild;
+
 //! @cond
+struct Rebuild {
+	CityMap *cityMap;
+	Road *road;
+	const RouteTable *trunks;
+	Trunk **replacements;
+};
+
 static bool addFromList(Map *map, NameList list, const int *years, const unsigned *roadLengths);
 static bool correctRoute(unsigned routeId, const char *name1, const char *name2);
+static bool current(const MapQuery *query);
 static bool destroyRoad(Map *map, Road *road);
 static bool invalidId(unsigned routeId);
 static bool namesAreCorrect(const char *city1, const char *city2);
@@ -29,13 +60,13 @@ static bool testExistingRoads(Map *map, const char **names, const unsigned *road
 static bool testNameUniqueness(const char **names, size_t length);
 static bool testRoute(Map *map, const char **names, const int *years, const unsigned *roadLengths, size_t length);
 static bool testYears(Map *map, const char **names, const int *years, size_t length);
+static void addDetour(void *context, Search *search, size_t index);
 static void destroyTrunks(Map *map);
 static void repairFromList(Map *map, NameList list, const int *years);
 static Road *find(Trie *trie, const char *city1, const char *city2);
 
 #ifndef NDEBUG
 static bool testInvariants(Map *map);
-static bool *whichTrunks(const Map *map);
 #endif // NDEBUG
 //! @endcond
 
@@ -48,8 +79,16 @@ Map *newMap(void) {
 			if (ans->cities) {
 				ans->roads = roadMapInit();
 				if (ans->roads) {
-					assert(testInvariants(ans));
-					return ans;
+					ans->search = searchInit();
+					if (ans->search) {
+						ans->routes = routeTableInit();
+						if (ans->routes) {
+							assert(testInvariants(ans));
+							return ans;
+						}
+						searchDestroy(&ans->search);
+					}
+					roadMapDestroy(&ans->roads);
 				}
 				free(ans->cities);
 			}
@@ -63,11 +102,13 @@ Map *newMap(void) {
 void deleteMap(Map *map) {
 	if (map == NULL)
 		return;
-	assert(map->routes[0] == NULL);
+	assert(routeTableFind(map->routes, 0) == NULL);
 	destroyTrunks(map);
+	routeTableDestroy(&map->routes);
 	cityMapDestroy(&map->cities);
 	roadMapDestroy(&map->roads);
 	trieDestroy(&map->trie);
+	searchDestroy(&map->search);
 	free(map);
 }
 
@@ -100,6 +141,8 @@ bool addRoad(Map *map, const char *city1, const char *city2, unsigned length, in
 		if (!c1 && !c2)
 			ans = roadLoneRoad(map->cities, map->trie, info);
 	}
+	if (ans)
+		searchNoteRoad(map->search, find(map->trie, city1, city2));
 	if (ans && c1) {
 		(void) count1;
 		assert(cityGetRoadCount(c1) == count1 + 1);
@@ -118,6 +161,8 @@ bool repairRoad(Map *map, const char *city1, const char *city2, int repairYear)
 	if (r == NULL)
 		return false;
 	ans = roadUpdate(r, repairYear);
+	if (ans)
+		searchNoteRepair(map->search, r);
 	assert(testInvariants(map));
 	return ans;
 }
@@ -129,12 +174,15 @@ bool newRoute(Map *map, unsigned routeId, const char *city1, const char *city2)
 	c2 = trieFind(map->trie, city2);
 	if (!correctRoute(routeId, city1, city2))
 		return false;
-	if (c1 && c2 && map->routes[routeId] == NULL) {
-		route = trunkBuild(c1, c2, map->cities, routeId);
+	if (c1 && c2 && routeTableFind(map->routes, routeId) == NULL) {
+		if (!routeTableReserve(map->routes))
+			return false;
+		if (!exclusionReset(searchExclusion(map->search), cityMapGetLength(map->cities)))
+			return false;
+		route = trunkBuild(c1, c2, map->cities, map->search, routeId);
 		if (route) {
 			if (trunkGetLength(route) < SIZE_MAX) {
-				assert(routeId < ROUTE_LIMIT);
-				map->routes[routeId] = route;
+				routeTableInsert(map->routes, route);
 				trunkAttach(route);
 				assert(trunkTest(route));
 				assert(testInvariants(map));
@@ -149,17 +197,17 @@ bool newRoute(Map *map, unsigned routeId, const char *city1, const char *city2)
 bool extendRoute(Map *map, unsigned routeId, const char *city) {
 	City *c;
 	Trunk *extension, *route;
-	if (invalidId(routeId) || nameError(city) || map->routes[routeId] == NULL)
+	if (invalidId(routeId) || nameError(city))
 		return false;
 	c = trieFind(map->trie, city);
-	route = map->routes[routeId];
-	if (c == NULL || trunkHasCity(route, c))
+	route = routeTableFind(map->routes, routeId);
+	if (route == NULL || c == NULL || trunkHasCity(route, c))
 		return false;
-	extension = trunkExtend(map->cities, route, c);
+	extension = trunkExtend(map->cities, route, c, map->search);
 	assert(testInvariants(map));
 	if (extension == NULL)
 		return false;
-	map->routes[routeId] = extension;
+	routeTableReplace(map->routes, extension);
 	trunkAttach(extension);
 	trunkFree(&route);
 	assert(testInvariants(map));
@@ -173,18 +221,157 @@ bool removeRoad(Map *map, const char *city1, const char *city2) {
 	if (r == NULL)
 		return false;
 	ans = destroyRoad(map, r);
-	assert(!map->routes[410] || trunkTest(map->routes[410]));
 	if (ans)
 		assert(find(map->trie, city1, city2) == NULL);
 	assert(testInvariants(map));
 	return ans;
 }
 
+bool mapReorder(Map *map) {
+	bool ans = cityMapReorder(map->cities);
+	if (ans)
+		searchRenumber(map->search, map->cities);
+	assert(testInvariants(map));
+	return ans;
+}
+
+bool mapPrepareLandmarks(Map *map, unsigned count) {
+	return searchPrepareLandmarks(map->search, map->cities, count);
+}
+
+bool mapPrepareWorkers(Map *map, unsigned threadCount) {
+	return searchPrepareWorkers(map->search, threadCount);
+}
+
+void mapUseStepping(Map *map, unsigned delta) {
+	searchUseStepping(map->search, delta);
+}
+
+bool mapPrepareOverlay(Map *map, unsigned cellSize) {
+	return searchPrepareOverlay(map->search, map->cities, cellSize);
+}
+
+size_t mapCityCount(const Map *map) {
+	return cityMapGetLength(map->cities);
+}
+
+size_t mapCityId(Map *map, const char *city) {
+	City *c = (nameError(city) ? NULL : trieFind(map->trie, city));
+	return (c ? cityGetId(c) : SIZE_MAX);
+}
+
+bool mapDistancesFrom(Map *map, const char *city, CityDistance *distances) {
+	City *c = (nameError(city) ? NULL : trieFind(map->trie, city));
+	if (c == NULL)
+		return false;
+	if (!exclusionReset(searchExclusion(map->search), cityMapGetLength(map->cities)))
+		return false;
+	return searchDistances(map->search, c, map->cities, distances);
+}
+
+bool mapDistanceMatrix(Map *map, const char **sources, size_t sourceCount,
+		const char **targets, size_t targetCount, CityDistance *distances) {
+	City **cities = malloc((sourceCount + targetCount > 0 ? sourceCount + targetCount : 1) * sizeof(City *));
+	if (cities == NULL)
+		return false;
+	for (size_t i = 0; i < sourceCount + targetCount; ++i) {
+		const char *name = (i < sourceCount ? sources[i] : targets[i - sourceCount]);
+		cities[i] = (nameError(name) ? NULL : trieFind(map->trie, name));
+		if (cities[i] == NULL) {
+			free(cities);
+			return false;
+		}
+	}
+	const bool ans = searchMatrix(map->search, cities, sourceCount, cities + sourceCount, targetCount, map->cities, distances);
+	free(cities);
+	return ans;
+}
+
+MapQuery *mapQueryBegin(Map *map, const char *city1, const char *city2, const struct timespec *deadline) {
+	if (!namesAreCorrect(city1, city2))
+		return NULL;
+	City *c1 = trieFind(map->trie, city1), *c2 = trieFind(map->trie, city2);
+	Search *search = searchStepped(map->search);
+	if (c1 == NULL || c2 == NULL || search == NULL)
+		return NULL;
+	MapQuery *ans = malloc(sizeof(MapQuery));
+	if (ans) {
+		searchCancel(search);
+		if (exclusionReset(searchExclusion(search), cityMapGetLength(map->cities))) {
+			searchBegin(search, c1, c2, map->cities, SIZE_MAX, deadline);
+			*ans = (MapQuery) {.search = search, .version = searchVersion(search)};
+			return ans;
+		}
+		free(ans);
+	}
+	return NULL;
+}
+
+bool mapQueryStep(MapQuery *query, size_t budget) {
+	if (!current(query))
+		return true;
+	return searchStep(query->search, budget);
+}
+
+bool mapQueryDone(const MapQuery *query) {
+	return !current(query) || searchDone(query->search);
+}
+
+// the path isn't kept, so the result can be taken once
+bool mapQueryResult(MapQuery *query, CityDistance *path) {
+	size_t length;
+	assert(mapQueryDone(query));
+	if (!current(query))
+		return false;
+	Road **roads = searchResult(query->search, &length);
+	if (length == 0)
+		return false;
+	*path = (CityDistance) {.distance = SIZE_MAX, .year = 0, .unique = false};
+	if (length == SIZE_MAX)
+		return true;
+	*path = (CityDistance) {.distance = 0, .year = INT_MAX, .unique = true};
+	for (size_t i = 0; i < length; ++i) {
+		path->distance += roadGetLength(roads[i]);
+		if (roadGetYear(roads[i]) < path->year)
+			path->year = roadGetYear(roads[i]);
+	}
+	free(roads);
+	return true;
+}
+
+void mapQueryDelete(MapQuery *query) {
+	if (query == NULL)
+		return;
+	if (current(query))
+		searchCancel(query->search);
+	free(query);
+}
+
+void mapSearchStatistics(const Map *map, size_t *hits, size_t *misses) {
+	searchStatistics(map->search, hits, misses);
+}
+
+City *mapGetCity(Map *map, const char *city) {
+	return trieFind(map->trie, city);
+}
+
+CityMap *mapGetCities(Map *map) {
+	return map->cities;
+}
+
+Road *mapGetRoad(Map *map, const char *city1, const char *city2) {
+	return find(map->trie, city1, city2);
+}
+
+Search *mapGetSearch(Map *map) {
+	return map->search;
+}
+
 char *routeDescriptionAux(Map *map, unsigned routeId) {
 	char *ans = calloc(1, sizeof(char));
 	if (ans) {
 		if (!invalidId(routeId)) {
-			Trunk *route = map->routes[routeId];
+			Trunk *route = routeTableFind(map->routes, routeId);
 			if (route != NULL) {
 				free(ans);
 				ans = trunkDescription(route);
@@ -194,19 +381,24 @@ char *routeDescriptionAux(Map *map, unsigned routeId) {
 	return ans;
 }
 
-Trunk **rebuildTrunks(CityMap *cityMap, Road *road, Trunk *trunks[ROUTE_LIMIT]) {
+// the detours are searched for in parallel, nothing is kept unless all are found
+Trunk **rebuildTrunks(CityMap *cityMap, Road *road, const RouteTable *trunks, Search *search) {
 	const unsigned routeCount = roadRouteCount(road);
-	unsigned ids[ROUTE_LIMIT];
-	roadGetIds(road, ids);
 	Trunk **replacements = calloc(routeCount, sizeof(Trunk *));
 	if (replacements == NULL)
 		return NULL;
+	Rebuild rebuild = {
+		.cityMap = cityMap,
+		.road = road,
+		.trunks = trunks,
+		.replacements = replacements,
+	};
+	searchEach(search, routeCount, addDetour, &rebuild);
 	for (size_t i = 0; i < routeCount; ++i) {
-		unsigned trunkId = ids[i];
-		replacements[i] = trunkAddDetour(cityMap, trunks[trunkId], road);
 		if (replacements[i] == NULL) {
-			for (size_t j = 0; j < i; ++j) {
-				trunkFree(&replacements[j]);
+			for (size_t j = 0; j < routeCount; ++j) {
+				if (replacements[j])
+					trunkFree(&replacements[j]);
 			}
 			free(replacements);
 			return NULL;
@@ -225,7 +417,9 @@ bool routeFromList(
 ) {
 	if (!testRoute(map, names, years, rLengths, length))
 		return false;
-	if (invalidId(id) || map->routes[id])
+	if (invalidId(id) || routeTableFind(map->routes, id))
+		return false;
+	if (!routeTableReserve(map->routes))
 		return false;
 	const size_t cityCount = cityMapGetLength(map->cities);
 	const size_t roadCount = roadMapGetLength(map->roads);
@@ -244,7 +438,7 @@ bool routeFromList(
 			}
 			if (insertSuccess) {
 				assert(!invalidId(id));
-				map->routes[id] = trunk;
+				routeTableInsert(map->routes, trunk);
 				repairFromList(map, list, years);
 				trunkAttach(trunk);
 				assert(trunkTest(trunk));
@@ -252,8 +446,15 @@ bool routeFromList(
 			}
 			trunkFree(&trunk);
 		}
+		// the search and the cities that stay have seen the new roads
+		for (size_t i = roadMapGetLength(map->roads); i > roadCount; --i)
+			destroyRoad(map, roadMapGet(map->roads, i - 1));
+		const bool newCities = cityCount < cityMapGetLength(map->cities);
 		cityMapTrim(map->cities, cityCount);
 		roadMapTrim(map->roads, roadCount);
+		// the ids of the removed cities will be given to others
+		if (newCities)
+			searchRenumber(map->search, map->cities);
 	}
 	return false;
 }
@@ -265,9 +466,10 @@ const char *getRouteDescription(Map *map, unsigned routeId) {
 bool removeRoute(Map *map, unsigned routeId) {
 	if (invalidId(routeId))
 		return false;
-	if (map->routes[routeId] == NULL)
+	Trunk *route = routeTableRemove(map->routes, routeId);
+	if (route == NULL)
 		return false;
-	trunkDestroy(&map->routes[routeId]);
+	trunkDestroy(&route);
 	return true;
 }
 
@@ -276,11 +478,12 @@ static bool destroyRoad(Map *map, Road *road) {
 	City *city1, *city2;
 	roadGetCities(road, &city1, &city2);
 	if (roadRouteCount(road) > 0) {
-		bool moveSuccess = roadMoveTrunks(map->cities, map->routes, road);
+		bool moveSuccess = roadMoveTrunks(map->cities, map->routes, road, map->search);
 		assert(testInvariants(map));
 		if (!moveSuccess)
 			return false;
 	}
+	searchNoteRemoval(map->search, road);
 	roadDetach(road, city1);
 	roadDetach(road, city2);
 	return true;
@@ -308,6 +511,10 @@ static bool nameError(const char *str) {
 	return false;
 }
 
+static bool current(const MapQuery *query) {
+	return searchVersion(query->search) == query->version;
+}
+
 static bool correctRoute(unsigned routeId, const char *name1, const char *name2) {
 	bool ans = true;
 	ans = ans && strcmp(name1, name2) != 0;
@@ -316,7 +523,7 @@ static bool correctRoute(unsigned routeId, const char *name1, const char *name2)
 }
 
 static bool invalidId(unsigned routeId) {
-	return routeId < 1 || routeId >= ROUTE_LIMIT;
+	return routeId < 1;
 }
 
 static bool testNameUniqueness(const char **names, size_t length) {
@@ -395,7 +602,7 @@ static bool addFromList(Map *map, NameList list, const int *years, const unsigne
 			road = find(map->trie, city1, city2);
 		}
 		assert(road);
-		bool reserveSuccess = roadReserve(road);
+		bool reserveSuccess = roadReserve(road, 1);
 		if (!reserveSuccess) {
 			assert(false);
 			return false;
@@ -414,10 +621,17 @@ static Road *find(Trie *trie, const char *city1, const char *city2) {
 		return NULL;
 }
 
+static void addDetour(void *context, Search *search, size_t index) {
+	Rebuild *rebuild = context;
+	Trunk *trunk = routeTableFind(rebuild->trunks, roadGetRoute(rebuild->road, index));
+	rebuild->replacements[index] = trunkAddDetour(rebuild->cityMap, trunk, rebuild->road, search);
+}
+
 static void destroyTrunks(Map *map) {
-	for (size_t i = 1; i < ROUTE_LIMIT; ++i) {
-		if (map->routes[i] != NULL)
-			trunkDestroy(&map->routes[i]);
+	for (size_t i = routeTableCount(map->routes); i > 0; --i) {
+		Trunk *route = routeTableGet(map->routes, i - 1);
+		routeTableRemove(map->routes, trunkGetId(route));
+		trunkDestroy(&route);
 	}
 }
 
@@ -433,6 +647,7 @@ static void repairFromList(Map *map, NameList list, const int *years) {
 		success = roadUpdate(road, years[i - 1]);
 		(void) success;
 		assert(success);
+		searchNoteRepair(map->search, road);
 	}
 }
 
@@ -442,36 +657,19 @@ static bool testInvariants(Map *map) {
 	if (!roadMapTestCount(map->roads)) {
 		return false;
 	}
-	{
-		bool success, *trunks = whichTrunks(map);
-		success = roadMapTestTrunk(map->roads, trunks);
-		free(trunks);
-		if (!success) {
-			return false;
-		}
+	if (!roadMapTestTrunk(map->roads, map->routes)) {
+		return false;
 	}
 	if (cityMapTest(map->cities, map->trie) == false)
 		return false;
 	{
-		for (size_t i = 0; i < ROUTE_LIMIT; ++i) {
-			if (map->routes[i])
-				if (!trunkTest(map->routes[i])) {
-					return false;
-				}
+		for (size_t i = 0; i < routeTableCount(map->routes); ++i) {
+			if (!trunkTest(routeTableGet(map->routes, i))) {
+				return false;
+			}
 		}
 	}
 	return true;
 }
 #endif // NDEBUG
-
-// debug function used only in assertions
-#ifndef NDEBUG
-static bool *whichTrunks(const Map *map) {
-	bool *ans = calloc(ROUTE_LIMIT, sizeof(bool));
-	assert(ans);
-	for (size_t i = 0; i < ROUTE_LIMIT; ++i)
-		ans[i] = (map->routes[i] != NULL);
-	return ans;
-}
-#endif // NDEBUG
 //! @endcond
@@ -11,6 +11,7 @@
 
 #include <stdbool.h>
 #include <stdlib.h>
+#include <time.h>
 #include "global_declarations.h"
 
 /** @brief Create a new map structure.
@@ -141,6 +142,175 @@ bool removeRoad(Map *map, const char *city1, const char *city2);
  */
 bool removeRoute(Map *map, unsigned routeId);
 
+/** @brief Renumber the cities to make path searches more cache friendly.
+ * Computes a bandwidth-reducing order of the cities (reverse Cuthill-McKee)
+ * and assigns the ids accordingly, so that cities connected by a road get
+ * close ids. Meant to be called after loading a large number of roads; the
+ * results of other operations are not affected.
+ * @param[in,out] map    – pointer to the road map structure;
+ * @return @p true if the cities were renumbered, @p false if memory
+ * allocation failed, in which case the map is unchanged.
+ */
+bool mapReorder(Map *map);
+
+/** @brief Choose landmarks to speed up the search for new Routes.
+ * Picks up to @p count cities far away from each other and finds the
+ * distances from them to all cities. Searches then use these to go towards
+ * their targets. The distances are kept up to date as roads are added; the
+ * results of other operations are not affected.
+ * @param[in,out] map    – pointer to the road map structure;
+ * @param[in] count      – number of landmarks, 0 to stop using them.
+ * @return @p true if the landmarks were prepared, @p false if memory
+ * allocation failed, in which case searches don't use landmarks.
+ */
+bool mapPrepareLandmarks(Map *map, unsigned count);
+
+/** @brief Split the map into cells to speed up the search for new Routes.
+ * Groups connected cities into cells of up to @p cellSize cities and finds
+ * the shortest paths across every cell. A new Route is then searched for
+ * road by road only in the cells of its ends. The paths across a cell are
+ * found again when one of its roads changes; the results of other
+ * operations are not affected.
+ * @param[in,out] map    – pointer to the road map structure;
+ * @param[in] cellSize   – number of cities in a cell, 0 to stop using them.
+ * @return @p true if the cells were prepared, @p false if memory allocation
+ * failed, in which case searches don't use cells.
+ */
+bool mapPrepareOverlay(Map *map, unsigned cellSize);
+
+/** @brief Starts threads searching for detours in parallel.
+ * When a road is removed, the detours of the Routes going through it are
+ * searched for at once by these threads and the calling one, each with a
+ * workspace of its own. The results are the same as without the threads.
+ * @param[in,out] map      – pointer to the road map structure;
+ * @param[in] threadCount  – number of threads besides the calling one, 0 to
+ * stop them.
+ * @return @p true if the threads were started, @p false if memory
+ * allocation or starting a thread failed, in which case there are none.
+ */
+bool mapPrepareWorkers(Map *map, unsigned threadCount);
+
+/** @brief Gives the number of cities in the map.
+ * The cities have ids from 0 to one less than this number.
+ * @param[in] map        – pointer to the road map structure.
+ * @return Number of cities in the map.
+ */
+size_t mapCityCount(const Map *map);
+
+/** @brief Gives the id of a city.
+ * Ids change only when the cities are renumbered by @ref mapReorder.
+ * @param[in] map        – pointer to the road map structure;
+ * @param[in] city       – pointer to a string with the name of the city.
+ * @return Id of the city, SIZE_MAX if there is no such city.
+ */
+size_t mapCityId(Map *map, const char *city);
+
+/** @brief Chooses how the distances from a city to all others are found.
+ * With a width other than 0, @ref mapDistancesFrom takes the cities in
+ * buckets of that many units of distance and splits every bucket between the
+ * threads started by @ref mapPrepareWorkers and the calling one, instead of
+ * taking the cities one at a time. The results are the same either way.
+ * Very wide buckets are narrowed, and if the longest road spans too many
+ * buckets, the cities are taken one at a time.
+ * @param[in,out] map  – pointer to the road map structure;
+ * @param[in] delta    – width of a bucket, 0 to take the cities one at a time.
+ */
+void mapUseStepping(Map *map, unsigned delta);
+
+/** @brief Finds the distances from a city to all others.
+ * Runs a single search over the whole map instead of one per city. For
+ * every city the length of the shortest paths is given, along with the
+ * highest minimum year among them and whether a Route could follow the best
+ * one; the city itself is at distance 0.
+ * @param[in,out] map    – pointer to the road map structure;
+ * @param[in] city       – pointer to a string with the name of the city;
+ * @param[out] distances – an array of @ref mapCityCount records, filled by
+ * city id.
+ * @return @p true if the distances were found, @p false if there is no such
+ * city or memory allocation failed.
+ */
+bool mapDistancesFrom(Map *map, const char *city, CityDistance *distances);
+
+/** @brief Finds the distances from some cities to others.
+ * Runs a search from every source, stopping once it has reached all the
+ * targets. The searches are split between the threads started by
+ * @ref mapPrepareWorkers and the calling one.
+ * @param[in,out] map      – pointer to the road map structure;
+ * @param[in] sources      – names of the cities the paths start in;
+ * @param[in] sourceCount  – number of sources;
+ * @param[in] targets      – names of the cities the paths end in;
+ * @param[in] targetCount  – number of targets;
+ * @param[out] distances   – an array of @p sourceCount rows of
+ * @p targetCount records, the record of a source and a target is in the row
+ * of the source and the column of the target.
+ * @return @p true if the distances were found, @p false if one of the
+ * cities doesn't exist or memory allocation failed.
+ */
+bool mapDistanceMatrix(Map *map, const char **sources, size_t sourceCount,
+		const char **targets, size_t targetCount, CityDistance *distances);
+
+/** @brief Begins a query for the best path between two cities, run by steps.
+ * The query is run by @ref mapQueryStep a number of cities at a time, so
+ * that other work can be done in between, and fails once the deadline
+ * passes. The queries of a map run in a workspace of their own, so other
+ * commands don't disturb them, but a query fails if the map changes before
+ * it is over. Only the query begun last can go on: beginning a query stops
+ * any other query of the map still in progress, without a warning, and
+ * that one then behaves as if it had failed.
+ * The query must be removed by @ref mapQueryDelete before the map is.
+ * @param[in,out] map    – pointer to the road map structure;
+ * @param[in] city1      – pointer to a string with the name of the city
+ * the path begins in;
+ * @param[in] city2      – pointer to a string with the name of the city
+ * the path ends in;
+ * @param[in] deadline   – the time measured by @p TIME_UTC at which the
+ * query fails, NULL if it has none.
+ * @return Pointer to the query or NULL if a name is incorrect, there is no
+ * such city, both names are the same or memory allocation failed.
+ */
+MapQuery *mapQueryBegin(Map *map, const char *city1, const char *city2, const struct timespec *deadline);
+
+/** @brief Runs a query for up to a number of cities.
+ * @param[in,out] query  – pointer to the query;
+ * @param[in] budget     – the number of cities the query may take.
+ * @return @p true if the query is over.
+ */
+bool mapQueryStep(MapQuery *query, size_t budget);
+
+/** @brief Checks if a query is over.
+ * @param[in] query      – pointer to the query.
+ * @return @p true if the query found its result or failed.
+ */
+bool mapQueryDone(const MapQuery *query);
+
+/** @brief Gives the result of a query that is over.
+ * The path is described the same way as by @ref mapDistancesFrom, with the
+ * lowest year of its roads; if there is no path, or no single best one, its
+ * distance is @p SIZE_MAX. The result can be taken once.
+ * @param[in,out] query  – pointer to the query;
+ * @param[out] path      – the path found.
+ * @return @p true if the query has a result, @p false if it failed because
+ * of its deadline, a change of the map, a later query or memory allocation.
+ */
+bool mapQueryResult(MapQuery *query, CityDistance *path);
+
+/** @brief Removes a query.
+ * A query that isn't over is given up. Does nothing when a NULL argument is
+ * passed.
+ * @param[in] query      – pointer to the query being removed.
+ */
+void mapQueryDelete(MapQuery *query);
+
+/** @brief Gives the number of path searches answered from the cache.
+ * The results of the searches made for Routes are kept until the map
+ * changes in a way that can affect them: adding or removing a road affects
+ * all of them, a repair only those with several shortest paths.
+ * @param[in] map        – pointer to the road map structure;
+ * @param[out] hits      – number of searches answered from the cache;
+ * @param[out] misses    – number of searches run in full.
+ */
+void mapSearchStatistics(const Map *map, size_t *hits, size_t *misses);
+
 /** @brief Describes a Route, returns a modifiable string.
  * Returns a string describing a Route. Memory is allocated for the description
  * and must be released using the free function.
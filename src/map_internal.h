@@ -0,0 +1,19 @@
+/** @file
+ * Access to the structures behind the map interface, used by the tests.
+ */
+
+#ifndef MAP_MAP_INTERNAL_H
+#define MAP_MAP_INTERNAL_H
+
+#include "global_declarations.h"
+
+/// find a city by name, NULL if there is none
+City *mapGetCity(Map *map, const char *city);
+/// get the cities of the map
+CityMap *mapGetCities(Map *map);
+/// find the road between two cities given by name, NULL if there is none
+Road *mapGetRoad(Map *map, const char *city1, const char *city2);
+/// get the workspace used by the commands of the map
+Search *mapGetSearch(Map *map);
+
+#endif //MAP_MAP_INTERNAL_H
@@ -0,0 +1,651 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "city.h"
+#include "city_map.h"
+#include "overlay.h"
+#include "queue.h"
+#include "road.h"
+
+#define INIT_SPACE 8
+#define NONE SIZE_MAX
+
+/// A group of connected cities.
+typedef struct Cell Cell;
+
+/// The result of a search for a single city, or a city entered or left.
+typedef struct OverlayRecord OverlayRecord;
+
+/// The shortest paths between two cities on the boundary of a cell.
+typedef struct Shortcut Shortcut;
+
+/** The road map split into cells, with shortcuts across them.
+ * A cell keeps the shortest paths inside it between its cities with roads
+ * leading out of it, along with the two highest minimum years of these
+ * paths. A search goes road by road only in the cells of its ends, other
+ * cells are crossed by shortcuts. A city of such a cell can be entered by a
+ * road from outside of it or left by one; the search only takes a shortcut
+ * after entering and only leaves by a road, so every path of the map is
+ * made of roads and shortcuts in exactly one way and the minimum years of
+ * all shortest paths are taken into account.
+ *
+ * A change of a road only marks the cells of its ends, their shortcuts are
+ * found again before the next search. A new city joins the cell of its
+ * neighbour.
+ */
+struct Overlay {
+	/// the cells
+	Cell *cells;
+	/// cells of the cities, NONE for cities without roads, indexed by id
+	size_t *cellOf;
+	/// positions of the cities on the boundaries of their cells, by id
+	size_t *slots;
+	/// cells with shortcuts that have to be found again
+	size_t *dirty;
+	/// records of the overlay search, for entering and leaving every city
+	OverlayRecord *records;
+	/// records of a search inside a single cell, indexed by city id
+	OverlayRecord *local;
+	/// the priority queue, kept to avoid reallocating it
+	Heap *queue;
+	/// number of cells
+	size_t cellCount;
+	/// number of cells there is space for
+	size_t cellMax;
+	/// number of cells with shortcuts that have to be found again
+	size_t dirtyCount;
+	/// number of cities there is space for
+	size_t length;
+	/// the cells searched road by road, those of the ends of the path
+	size_t open1, open2;
+	/// the epoch of the records of the overlay search
+	unsigned epoch;
+	/// the epoch of the records of the search inside a cell
+	unsigned localEpoch;
+	/// the number of cities the cells were made with
+	unsigned cellSize;
+	/// length of the longest road in the map
+	unsigned longest;
+};
+
+//! @cond
+struct Cell {
+	/// cities of the cell
+	City **cities;
+	/// cities with roads leading out of the cell
+	City **boundary;
+	/// paths from every city on the boundary to every other, by rows
+	Shortcut *shortcuts;
+	/// number of cities
+	size_t count;
+	/// number of cities there is space for
+	size_t capacity;
+	/// number of cities on the boundary
+	size_t boundaryCount;
+	/// true if the shortcuts have to be found again
+	bool dirty;
+};
+
+struct OverlayRecord {
+	/// length of the shortest path found so far
+	size_t distance;
+	/// the record the best path comes from, NONE at the start
+	size_t parent;
+	/// the last road of the best path, NULL if it ends with a shortcut
+	Road *road;
+	/// the epoch of the search the record belongs to
+	unsigned stamp;
+	/// the highest minimum year among the shortest paths
+	int year;
+	/// the second highest minimum year, valid if there are two paths
+	int year2;
+	/// number of the shortest paths, counting stops at two
+	unsigned char paths;
+	/// true if the distance is final
+	bool settled;
+};
+
+struct Shortcut {
+	/// length of the shortest paths, valid if there are any
+	size_t distance;
+	/// the highest minimum year among the shortest paths
+	int year;
+	/// the second highest minimum year, valid if there are two paths
+	int year2;
+	/// number of the shortest paths, counting stops at two
+	unsigned char paths;
+};
+
+static bool adjust(Overlay *overlay, size_t cityCount);
+static bool cellAdd(Overlay *overlay, size_t index, City *city);
+static bool customize(Overlay *overlay, size_t index);
+static bool isBoundary(const Overlay *overlay, const City *city);
+static bool isOpen(const Overlay *overlay, size_t index);
+static bool isUnique(const OverlayRecord *record);
+static bool partition(Overlay *overlay, CityMap *cityMap);
+static bool push(Road ***pRoads, size_t *count, size_t *capacity, Road *road);
+static bool relax(OverlayRecord *record, unsigned stamp, const OverlayRecord *position,
+		size_t distance, int year, int year2, unsigned char paths);
+static bool search(Overlay *overlay, City *from, City *to);
+static bool sweep(Overlay *overlay, size_t index, City *from);
+static size_t addCell(Overlay *overlay);
+static unsigned bump(OverlayRecord *records, size_t count, unsigned *pEpoch);
+static void addYear(OverlayRecord *record, int year);
+static void enter(Overlay *overlay, size_t state, const OverlayRecord *position, Road *road, City *city);
+static void expand(Overlay *overlay, size_t state, City *city);
+static void markDirty(Overlay *overlay, size_t index);
+static City *otherEnd(Road *road, City *city);
+static Road **unpack(Overlay *overlay, City *to, size_t *length);
+static OverlayRecord *touch(OverlayRecord *records, unsigned epoch, size_t index);
+//! @endcond
+
+Overlay *overlayInit(CityMap *cityMap, unsigned cellSize, unsigned longest) {
+	assert(cellSize > 0);
+	Overlay *ans = calloc(1, sizeof(Overlay));
+	if (ans) {
+		ans->cellSize = cellSize;
+		ans->longest = longest;
+		ans->open1 = ans->open2 = NONE;
+		ans->queue = queueInit();
+		if (ans->queue && adjust(ans, cityMapGetLength(cityMap)) && partition(ans, cityMap))
+			return ans;
+		overlayDestroy(&ans);
+	}
+	return NULL;
+}
+
+void overlayDestroy(Overlay **pOverlay) {
+	Overlay *overlay = *pOverlay;
+	for (size_t i = 0; i < overlay->cellCount; ++i) {
+		free(overlay->cells[i].cities);
+		free(overlay->cells[i].boundary);
+		free(overlay->cells[i].shortcuts);
+	}
+	if (overlay->queue)
+		queueDestroy(&overlay->queue);
+	free(overlay->cells);
+	free(overlay->cellOf);
+	free(overlay->slots);
+	free(overlay->dirty);
+	free(overlay->records);
+	free(overlay->local);
+	free(overlay);
+	*pOverlay = NULL;
+}
+
+unsigned overlayCellSize(const Overlay *overlay) {
+	return overlay->cellSize;
+}
+
+bool overlayNoteRoad(Overlay *overlay, Road *road) {
+	City *city1, *city2;
+	roadGetCities(road, &city1, &city2);
+	const size_t id1 = cityGetId(city1), id2 = cityGetId(city2);
+	if (roadGetLength(road) > overlay->longest)
+		overlay->longest = roadGetLength(road);
+	if (!adjust(overlay, (id1 > id2 ? id1 : id2) + 1))
+		return false;
+	if (overlay->cellOf[id1] == NONE && overlay->cellOf[id2] == NONE) {
+		size_t index = addCell(overlay);
+		if (index == NONE || !cellAdd(overlay, index, city1))
+			return false;
+	}
+	if (overlay->cellOf[id1] == NONE && !cellAdd(overlay, overlay->cellOf[id2], city1))
+		return false;
+	if (overlay->cellOf[id2] == NONE && !cellAdd(overlay, overlay->cellOf[id1], city2))
+		return false;
+	markDirty(overlay, overlay->cellOf[id1]);
+	markDirty(overlay, overlay->cellOf[id2]);
+	return true;
+}
+
+void overlayNoteChange(Overlay *overlay, Road *road) {
+	City *city1, *city2;
+	roadGetCities(road, &city1, &city2);
+	assert(cityGetId(city1) < overlay->length && cityGetId(city2) < overlay->length);
+	markDirty(overlay, overlay->cellOf[cityGetId(city1)]);
+	markDirty(overlay, overlay->cellOf[cityGetId(city2)]);
+}
+
+//out of memory errors set length to 0, lack of path to SIZE_MAX
+Road **overlayPath(Overlay *overlay, City *from, City *to, const CityMap *cityMap, size_t *length, bool *tied) {
+	*length = 0;
+	*tied = false;
+	if (!adjust(overlay, cityMapGetLength(cityMap)))
+		return NULL;
+	for (; overlay->dirtyCount > 0; --overlay->dirtyCount) {
+		if (!customize(overlay, overlay->dirty[overlay->dirtyCount - 1]))
+			return NULL;
+	}
+	if (!queuePrepare(overlay->queue, 2 * overlay->length, UINT32_MAX))
+		return NULL;
+	overlay->open1 = overlay->cellOf[cityGetId(from)];
+	overlay->open2 = overlay->cellOf[cityGetId(to)];
+	if (!search(overlay, from, to)) {
+		*length = SIZE_MAX;
+		return NULL;
+	}
+	*tied = overlay->records[2 * cityGetId(to)].paths > 1;
+	if (!isUnique(&overlay->records[2 * cityGetId(to)])) {
+		*length = SIZE_MAX;
+		return NULL;
+	}
+	return unpack(overlay, to, length);
+}
+
+//! @cond
+// the records that were added are zeroed, so they don't have a valid stamp
+static bool adjust(Overlay *overlay, size_t cityCount) {
+	if (cityCount <= overlay->length)
+		return true;
+	const size_t length = overlay->length;
+	size_t newLength = (length > 0 ? length : INIT_SPACE);
+	while (newLength < cityCount)
+		newLength *= 2;
+	size_t *cellOf = realloc(overlay->cellOf, newLength * sizeof(size_t));
+	if (cellOf == NULL)
+		return false;
+	overlay->cellOf = cellOf;
+	size_t *slots = realloc(overlay->slots, newLength * sizeof(size_t));
+	if (slots == NULL)
+		return false;
+	overlay->slots = slots;
+	OverlayRecord *records = realloc(overlay->records, 2 * newLength * sizeof(OverlayRecord));
+	if (records == NULL)
+		return false;
+	overlay->records = records;
+	OverlayRecord *local = realloc(overlay->local, newLength * sizeof(OverlayRecord));
+	if (local == NULL)
+		return false;
+	overlay->local = local;
+	for (size_t i = length; i < newLength; ++i)
+		cellOf[i] = slots[i] = NONE;
+	memset(records + 2 * length, 0, 2 * (newLength - length) * sizeof(OverlayRecord));
+	memset(local + length, 0, (newLength - length) * sizeof(OverlayRecord));
+	overlay->length = newLength;
+	return true;
+}
+
+static size_t addCell(Overlay *overlay) {
+	if (overlay->cellCount == overlay->cellMax) {
+		size_t newMax = (overlay->cellMax > 0 ? 2 * overlay->cellMax : INIT_SPACE);
+		Cell *cells = realloc(overlay->cells, newMax * sizeof(Cell));
+		if (cells == NULL)
+			return NONE;
+		overlay->cells = cells;
+		size_t *dirty = realloc(overlay->dirty, newMax * sizeof(size_t));
+		if (dirty == NULL)
+			return NONE;
+		overlay->dirty = dirty;
+		overlay->cellMax = newMax;
+	}
+	overlay->cells[overlay->cellCount] = (Cell) {
+		.cities = NULL,
+		.boundary = NULL,
+		.shortcuts = NULL,
+		.count = 0,
+		.capacity = 0,
+		.boundaryCount = 0,
+		.dirty = false,
+	};
+	return overlay->cellCount++;
+}
+
+static bool cellAdd(Overlay *overlay, size_t index, City *city) {
+	Cell *cell = &overlay->cells[index];
+	if (cell->count == cell->capacity) {
+		size_t newCapacity = (cell->capacity > 0 ? 2 * cell->capacity : INIT_SPACE);
+		City **tmp = realloc(cell->cities, newCapacity * sizeof(City *));
+		if (tmp == NULL)
+			return false;
+		cell->cities = tmp;
+		cell->capacity = newCapacity;
+	}
+	cell->cities[cell->count++] = city;
+	overlay->cellOf[cityGetId(city)] = index;
+	return true;
+}
+
+// the dirty list has space for all cells, so marking never fails
+static void markDirty(Overlay *overlay, size_t index) {
+	assert(index < overlay->cellCount);
+	if (!overlay->cells[index].dirty) {
+		overlay->cells[index].dirty = true;
+		overlay->dirty[overlay->dirtyCount++] = index;
+	}
+}
+
+/* every cell is grown from the first city left without one, taking the
+ * closest cities first, so that it doesn't spread along long roads
+ */
+static bool partition(Overlay *overlay, CityMap *cityMap) {
+	const size_t cityCount = cityMapGetLength(cityMap);
+	City *const *cities = (cityCount > 0 ? cityMapSuffix(cityMap, 0) : NULL);
+	Heap *queue = overlay->queue;
+	for (size_t i = 0; i < cityCount; ++i) {
+		if (overlay->cellOf[i] != NONE || cityGetRoadCount(cities[i]) == 0)
+			continue;
+		const size_t index = addCell(overlay);
+		if (index == NONE || !queuePrepare(queue, overlay->length, UINT32_MAX))
+			return false;
+		// the local records keep the distances of the cities queued
+		const unsigned epoch = bump(overlay->local, overlay->length, &overlay->localEpoch);
+		touch(overlay->local, epoch, i)->distance = 0;
+		queueUpdate(queue, cities[i], i, 0, 0);
+		while (!queueEmpty(queue) && overlay->cells[index].count < overlay->cellSize) {
+			size_t distance;
+			int year;
+			City *current = queuePop(queue, &distance, &year);
+			if (!cellAdd(overlay, index, current))
+				return false;
+			const size_t roadCount = cityGetRoadCount(current);
+			for (size_t k = 0; k < roadCount; ++k) {
+				City *next = cityNeighbour(current, k);
+				const size_t nextId = cityGetId(next);
+				const size_t nextDistance = distance + roadGetLength(cityGetRoad(current, k));
+				if (overlay->cellOf[nextId] != NONE)
+					continue;
+				OverlayRecord *record = touch(overlay->local, epoch, nextId);
+				if (record->paths == 0 || nextDistance < record->distance) {
+					record->distance = nextDistance;
+					record->paths = 1;
+					queueUpdate(queue, next, nextId, nextDistance, 0);
+				}
+			}
+		}
+		markDirty(overlay, index);
+	}
+	return true;
+}
+
+static bool isBoundary(const Overlay *overlay, const City *city) {
+	const size_t index = overlay->cellOf[cityGetId(city)];
+	const size_t roadCount = cityGetRoadCount(city);
+	for (size_t i = 0; i < roadCount; ++i) {
+		if (overlay->cellOf[cityGetId(cityNeighbour(city, i))] != index)
+			return true;
+	}
+	return false;
+}
+
+static bool isOpen(const Overlay *overlay, size_t index) {
+	return index == overlay->open1 || index == overlay->open2;
+}
+
+// finds the boundary of the cell again, then the paths between its cities
+static bool customize(Overlay *overlay, size_t index) {
+	Cell *cell = &overlay->cells[index];
+	size_t boundaryCount = 0;
+	for (size_t i = 0; i < cell->count; ++i) {
+		overlay->slots[cityGetId(cell->cities[i])] = NONE;
+		if (isBoundary(overlay, cell->cities[i]))
+			++boundaryCount;
+	}
+	// space for at least one city, so that nothing is allocated with size 0
+	const size_t space = (boundaryCount > 0 ? boundaryCount : 1);
+	City **boundary = realloc(cell->boundary, space * sizeof(City *));
+	if (boundary == NULL)
+		return false;
+	cell->boundary = boundary;
+	Shortcut *shortcuts = realloc(cell->shortcuts, space * space * sizeof(Shortcut));
+	if (shortcuts == NULL)
+		return false;
+	cell->shortcuts = shortcuts;
+	cell->boundaryCount = 0;
+	for (size_t i = 0; i < cell->count; ++i) {
+		if (isBoundary(overlay, cell->cities[i])) {
+			overlay->slots[cityGetId(cell->cities[i])] = cell->boundaryCount;
+			boundary[cell->boundaryCount++] = cell->cities[i];
+		}
+	}
+	for (size_t i = 0; i < boundaryCount; ++i) {
+		if (!sweep(overlay, index, boundary[i]))
+			return false;
+		for (size_t j = 0; j < boundaryCount; ++j) {
+			const OverlayRecord *record = &overlay->local[cityGetId(boundary[j])];
+			Shortcut *shortcut = &shortcuts[i * boundaryCount + j];
+			*shortcut = (Shortcut) {.paths = 0};
+			if (record->stamp == overlay->localEpoch && record->paths > 0) {
+				*shortcut = (Shortcut) {
+					.distance = record->distance,
+					.year = record->year,
+					.year2 = record->year2,
+					.paths = record->paths,
+				};
+			}
+		}
+	}
+	cell->dirty = false;
+	return true;
+}
+
+// starts a new search in the records, their stamps are cleared when the epoch wraps around
+static unsigned bump(OverlayRecord *records, size_t count, unsigned *pEpoch) {
+	if (*pEpoch == (unsigned) -1) {
+		for (size_t i = 0; i < count; ++i)
+			records[i].stamp = 0;
+		*pEpoch = 0;
+	}
+	return ++*pEpoch;
+}
+
+static OverlayRecord *touch(OverlayRecord *records, unsigned epoch, size_t index) {
+	OverlayRecord *ans = &records[index];
+	if (ans->stamp != epoch)
+		*ans = (OverlayRecord) {.stamp = epoch, .parent = NONE, .road = NULL, .paths = 0, .settled = false};
+	return ans;
+}
+
+// adds the minimum year of one more shortest path, keeps the two highest
+static void addYear(OverlayRecord *record, int year) {
+	if (record->paths == 0) {
+		record->year = year;
+		record->paths = 1;
+	} else if (year > record->year) {
+		record->year2 = record->year;
+		record->year = year;
+		record->paths = 2;
+	} else if (record->paths == 1 || year > record->year2) {
+		record->year2 = year;
+		record->paths = 2;
+	}
+}
+
+/* adds the paths made of those of the position and a road or a shortcut
+ * with the given years, returns true if the best path changed
+ */
+static bool relax(OverlayRecord *record, unsigned stamp, const OverlayRecord *position,
+		size_t distance, int year, int year2, unsigned char paths) {
+	if (record->paths > 0 && distance > record->distance)
+		return false;
+	if (record->paths == 0 || distance < record->distance) {
+		*record = (OverlayRecord) {.stamp = stamp, .parent = NONE, .road = NULL, .paths = 0, .settled = false};
+		record->distance = distance;
+	}
+	const bool fresh = (record->paths == 0);
+	const int oldYear = record->year;
+	addYear(record, position->year < year ? position->year : year);
+	if (position->paths > 1)
+		addYear(record, position->year2 < year ? position->year2 : year);
+	if (paths > 1)
+		addYear(record, position->year < year2 ? position->year : year2);
+	return fresh || record->year != oldYear;
+}
+
+// finds the paths inside a cell from one of its cities to all others
+static bool sweep(Overlay *overlay, size_t index, City *from) {
+	const unsigned epoch = bump(overlay->local, overlay->length, &overlay->localEpoch);
+	Heap *queue = overlay->queue;
+	if (!queuePrepare(queue, overlay->length, overlay->longest))
+		return false;
+	OverlayRecord *start = touch(overlay->local, epoch, cityGetId(from));
+	start->distance = 0;
+	start->year = INT16_MAX;
+	start->paths = 1;
+	queueUpdate(queue, from, cityGetId(from), 0, INT16_MAX);
+	while (!queueEmpty(queue)) {
+		size_t distance;
+		int minYear;
+		City *current = queuePop(queue, &distance, &minYear);
+		OverlayRecord *position = &overlay->local[cityGetId(current)];
+		position->settled = true;
+		const size_t roadCount = cityGetRoadCount(current);
+		for (size_t i = 0; i < roadCount; ++i) {
+			Road *road = cityGetRoad(current, i);
+			City *next = cityNeighbour(current, i);
+			const size_t nextId = cityGetId(next);
+			if (overlay->cellOf[nextId] != index)
+				continue;
+			OverlayRecord *record = touch(overlay->local, epoch, nextId);
+			if (record->settled)
+				continue;
+			const size_t nextDistance = distance + roadGetLength(road);
+			const int year = roadGetYear(road);
+			if (relax(record, epoch, position, nextDistance, year, year, 1)) {
+				record->road = road;
+				queueUpdate(queue, next, nextId, nextDistance, record->year);
+			}
+		}
+	}
+	return true;
+}
+
+/* a city of an open cell has a single record, one of a closed cell has the
+ * record of entering it at an even index and of leaving it after that
+ */
+static bool search(Overlay *overlay, City *from, City *to) {
+	const unsigned epoch = bump(overlay->records, 2 * overlay->length, &overlay->epoch);
+	OverlayRecord *start = touch(overlay->records, epoch, 2 * cityGetId(from));
+	start->distance = 0;
+	start->year = INT16_MAX;
+	start->paths = 1;
+	queueUpdate(overlay->queue, from, 2 * cityGetId(from), 0, INT16_MAX);
+	while (!queueEmpty(overlay->queue)) {
+		size_t state, distance;
+		int minYear;
+		City *current = queuePopId(overlay->queue, &state, &distance, &minYear);
+		overlay->records[state].settled = true;
+		if (current == to)
+			return true;
+		expand(overlay, state, current);
+	}
+	return false;
+}
+
+// entering a closed cell by a road means leaving it right away too
+static void enter(Overlay *overlay, size_t state, const OverlayRecord *position, Road *road, City *city) {
+	const size_t id = cityGetId(city);
+	const size_t distance = position->distance + roadGetLength(road);
+	const int year = roadGetYear(road);
+	const size_t last = (isOpen(overlay, overlay->cellOf[id]) ? 2 * id : 2 * id + 1);
+	for (size_t next = 2 * id; next <= last; ++next) {
+		OverlayRecord *record = touch(overlay->records, overlay->epoch, next);
+		if (record->settled)
+			continue;
+		if (relax(record, overlay->epoch, position, distance, year, year, 1)) {
+			record->parent = state;
+			record->road = road;
+			queueUpdate(overlay->queue, city, next, distance, record->year);
+		}
+	}
+}
+
+static void expand(Overlay *overlay, size_t state, City *city) {
+	const OverlayRecord position = overlay->records[state];
+	const size_t index = overlay->cellOf[state / 2];
+	if (state % 2 == 0 && !isOpen(overlay, index)) {
+		const Cell *cell = &overlay->cells[index];
+		const size_t row = overlay->slots[state / 2];
+		assert(row < cell->boundaryCount && !cell->dirty);
+		for (size_t j = 0; j < cell->boundaryCount; ++j) {
+			const Shortcut *shortcut = &cell->shortcuts[row * cell->boundaryCount + j];
+			if (j == row || shortcut->paths == 0)
+				continue;
+			City *exit = cell->boundary[j];
+			const size_t next = 2 * cityGetId(exit) + 1;
+			const size_t distance = position.distance + shortcut->distance;
+			OverlayRecord *record = touch(overlay->records, overlay->epoch, next);
+			if (record->settled)
+				continue;
+			if (relax(record, overlay->epoch, &position, distance, shortcut->year, shortcut->year2, shortcut->paths)) {
+				record->parent = state;
+				record->road = NULL;
+				queueUpdate(overlay->queue, exit, next, distance, record->year);
+			}
+		}
+		return;
+	}
+	const size_t roadCount = cityGetRoadCount(city);
+	for (size_t i = 0; i < roadCount; ++i) {
+		City *next = cityNeighbour(city, i);
+		if (state % 2 == 1 && overlay->cellOf[cityGetId(next)] == index)
+			continue;
+		enter(overlay, state, &position, cityGetRoad(city, i), next);
+	}
+}
+
+// the best path is unique if no other shortest path has the same minimum year
+static bool isUnique(const OverlayRecord *record) {
+	return record->paths < 2 || record->year2 < record->year;
+}
+
+static bool push(Road ***pRoads, size_t *count, size_t *capacity, Road *road) {
+	if (*count == *capacity) {
+		Road **tmp = realloc(*pRoads, 2 * *capacity * sizeof(Road *));
+		if (tmp == NULL)
+			return false;
+		*pRoads = tmp;
+		*capacity *= 2;
+	}
+	(*pRoads)[(*count)++] = road;
+	return true;
+}
+
+static City *otherEnd(Road *road, City *city) {
+	City *city1, *city2;
+	roadGetCities(road, &city1, &city2);
+	assert(city1 == city || city2 == city);
+	return (city1 != city ? city1 : city2);
+}
+
+/* the roads are collected from the end, a shortcut is replaced with the best
+ * path inside its cell, which is unique as the whole path is
+ */
+static Road **unpack(Overlay *overlay, City *to, size_t *length) {
+	size_t count = 0, capacity = INIT_SPACE;
+	Road **ans = malloc(capacity * sizeof(Road *));
+	bool success = (ans != NULL);
+	for (size_t state = 2 * cityGetId(to); success && overlay->records[state].parent != NONE;) {
+		const OverlayRecord *record = &overlay->records[state];
+		if (record->road) {
+			success = push(&ans, &count, &capacity, record->road);
+		} else {
+			const size_t index = overlay->cellOf[state / 2];
+			const Cell *cell = &overlay->cells[index];
+			City *entry = cell->boundary[overlay->slots[record->parent / 2]];
+			City *current = cell->boundary[overlay->slots[state / 2]];
+			success = sweep(overlay, index, entry);
+			while (success && current != entry) {
+				Road *road = overlay->local[cityGetId(current)].road;
+				success = push(&ans, &count, &capacity, road);
+				current = otherEnd(road, current);
+			}
+		}
+		state = record->parent;
+	}
+	if (!success) {
+		free(ans);
+		*length = 0;
+		return NULL;
+	}
+	for (size_t i = 0; i < count / 2; ++i) {
+		Road *tmp = ans[i];
+		ans[i] = ans[count - 1 - i];
+		ans[count - 1 - i] = tmp;
+	}
+	*length = count;
+	return ans;
+}
+//! @endcond
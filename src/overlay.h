@@ -0,0 +1,24 @@
+/** @file
+ * Interface for an overlay of the road map made of cells and shortcuts.
+ */
+
+#ifndef MAP_OVERLAY_H
+#define MAP_OVERLAY_H
+
+#include <stdbool.h>
+#include "global_declarations.h"
+
+/// get the highest number of cities the cells were made with
+unsigned overlayCellSize(const Overlay *overlay);
+/// take into account a road added to the map
+bool overlayNoteRoad(Overlay *overlay, Road *road);
+/// destroy the structure
+void overlayDestroy(Overlay **pOverlay);
+/// take into account a road repaired or about to be removed
+void overlayNoteChange(Overlay *overlay, Road *road);
+/// split the map into cells of connected cities
+Overlay *overlayInit(CityMap *cityMap, unsigned cellSize, unsigned longest);
+/// find the best path between two cities over the cells, tied if it was chosen by years
+Road **overlayPath(Overlay *overlay, City *from, City *to, const CityMap *cityMap, size_t *length, bool *tied);
+
+#endif //MAP_OVERLAY_H
@@ -0,0 +1,157 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <threads.h>
+
+#include "pool.h"
+
+/// A thread of the pool and its number.
+typedef struct PoolWorker PoolWorker;
+
+/** Threads waiting for tasks.
+ * The tasks of a batch are handed out one by one, so a thread that is done
+ * with a short task takes the next one while others are still busy. The
+ * thread that runs a batch takes tasks as well and returns once all of them
+ * have finished.
+ */
+struct Pool {
+	/// the threads, each with its number
+	PoolWorker *workers;
+	/// guards the fields below
+	mtx_t lock;
+	/// signalled when a batch starts or the pool is destroyed
+	cnd_t wake;
+	/// signalled when the last task of a batch finishes
+	cnd_t done;
+	/// the task of the batch in progress
+	PoolTask *task;
+	/// passed on to every task of the batch
+	void *context;
+	/// index of the next task to be handed out
+	size_t next;
+	/// number of tasks in the batch
+	size_t count;
+	/// number of tasks of the batch that have finished
+	size_t finished;
+	/// number of threads started
+	unsigned threadCount;
+	/// true if the threads should exit
+	bool stopping;
+};
+
+//! @cond
+struct PoolWorker {
+	/// the pool the thread belongs to
+	Pool *pool;
+	/// the thread itself
+	thrd_t thread;
+	/// number of the thread, counting from 1
+	unsigned number;
+};
+
+static int work(void *arg);
+static void stop(Pool *pool);
+static void take(Pool *pool, unsigned worker);
+//! @endcond
+
+Pool *poolInit(unsigned threadCount) {
+	Pool *ans = malloc(sizeof(Pool));
+	if (ans) {
+		*ans = (Pool) {
+			.next = 0,
+			.count = 0,
+			.finished = 0,
+			.threadCount = 0,
+			.stopping = false,
+			.workers = malloc(threadCount * sizeof(PoolWorker)),
+		};
+		if (ans->workers && mtx_init(&ans->lock, mtx_plain) == thrd_success) {
+			if (cnd_init(&ans->wake) == thrd_success) {
+				if (cnd_init(&ans->done) == thrd_success) {
+					for (unsigned i = 0; i < threadCount; ++i) {
+						PoolWorker *worker = &ans->workers[i];
+						*worker = (PoolWorker) {.pool = ans, .number = i + 1};
+						if (thrd_create(&worker->thread, work, worker) != thrd_success)
+							break;
+						++ans->threadCount;
+					}
+					if (ans->threadCount == threadCount)
+						return ans;
+					stop(ans);
+					cnd_destroy(&ans->done);
+				}
+				cnd_destroy(&ans->wake);
+			}
+			mtx_destroy(&ans->lock);
+		}
+		free(ans->workers);
+		free(ans);
+	}
+	return NULL;
+}
+
+void poolDestroy(Pool **pPool) {
+	Pool *pool = *pPool;
+	stop(pool);
+	cnd_destroy(&pool->done);
+	cnd_destroy(&pool->wake);
+	mtx_destroy(&pool->lock);
+	free(pool->workers);
+	free(pool);
+	*pPool = NULL;
+}
+
+unsigned poolThreadCount(const Pool *pool) {
+	return pool->threadCount;
+}
+
+void poolRun(Pool *pool, size_t count, PoolTask *task, void *context) {
+	mtx_lock(&pool->lock);
+	assert(pool->next == pool->count && pool->finished == pool->count);
+	pool->task = task;
+	pool->context = context;
+	pool->next = 0;
+	pool->finished = 0;
+	pool->count = count;
+	cnd_broadcast(&pool->wake);
+	take(pool, 0);
+	while (pool->finished < pool->count)
+		cnd_wait(&pool->done, &pool->lock);
+	mtx_unlock(&pool->lock);
+}
+
+//! @cond
+// runs tasks until none are left, called and returns with the lock held
+static void take(Pool *pool, unsigned worker) {
+	while (pool->next < pool->count) {
+		PoolTask *task = pool->task;
+		void *context = pool->context;
+		const size_t index = pool->next++;
+		mtx_unlock(&pool->lock);
+		task(context, worker, index);
+		mtx_lock(&pool->lock);
+		if (++pool->finished == pool->count)
+			cnd_signal(&pool->done);
+	}
+}
+
+static int work(void *arg) {
+	PoolWorker *worker = arg;
+	Pool *pool = worker->pool;
+	mtx_lock(&pool->lock);
+	while (!pool->stopping) {
+		take(pool, worker->number);
+		cnd_wait(&pool->wake, &pool->lock);
+	}
+	mtx_unlock(&pool->lock);
+	return 0;
+}
+
+static void stop(Pool *pool) {
+	mtx_lock(&pool->lock);
+	pool->stopping = true;
+	cnd_broadcast(&pool->wake);
+	mtx_unlock(&pool->lock);
+	for (unsigned i = 0; i < pool->threadCount; ++i)
+		thrd_join(pool->workers[i].thread, NULL);
+}
+//! @endcond
@@ -0,0 +1,23 @@
+/** @file
+ * Interface for a pool of threads running batches of independent tasks.
+ */
+
+#ifndef MAP_POOL_H
+#define MAP_POOL_H
+
+#include <stdbool.h>
+#include "global_declarations.h"
+
+/// A task of a batch, the worker is 0 for the calling thread and counts the threads from 1.
+typedef void PoolTask(void *context, unsigned worker, size_t index);
+
+/// get the number of threads, not counting the caller
+unsigned poolThreadCount(const Pool *pool);
+/// run tasks with indices from 0 to count - 1 and wait for all of them to finish
+void poolRun(Pool *pool, size_t count, PoolTask *task, void *context);
+/// stop the threads and destroy the pool
+void poolDestroy(Pool **pPool);
+/// start a number of threads waiting for tasks
+Pool *poolInit(unsigned threadCount);
+
+#endif //MAP_POOL_H
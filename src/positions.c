@@ -0,0 +1,99 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "positions.h"
+
+#define EMPTY SIZE_MAX
+
+/** Positions of distinct items in a sequence that doesn't change.
+ * The items are stored densely in the order of their positions, an open
+ * addressing hash table with linear probing maps each item to its position.
+ */
+struct Positions {
+	/// the items, by position
+	void **keys;
+	/// number of items in the sequence
+	size_t length;
+	/// number of items there is space for
+	size_t maxLength;
+	/// positions of the items, EMPTY if the slot is free
+	size_t *slots;
+	/// number of slots, a power of two at least twice maxLength
+	size_t slotCount;
+};
+
+//! @cond
+static size_t findSlot(const Positions *positions, const void *key);
+static size_t hash(const void *key, size_t slotCount);
+//! @endcond
+
+Positions *positionsInit(size_t maxLength) {
+	Positions *ans = malloc(sizeof(Positions));
+	if (ans) {
+		size_t slotCount = 2;
+		while (slotCount < 2 * maxLength)
+			slotCount *= 2;
+		*ans = (Positions) {
+			.length = 0,
+			.maxLength = maxLength,
+			.slotCount = slotCount,
+			.keys = malloc((maxLength > 0 ? maxLength : 1) * sizeof(void *)),
+			.slots = malloc(slotCount * sizeof(size_t)),
+		};
+		if (ans->keys && ans->slots) {
+			for (size_t i = 0; i < slotCount; ++i)
+				ans->slots[i] = EMPTY;
+			return ans;
+		}
+		free(ans->keys);
+		free(ans->slots);
+		free(ans);
+	}
+	return NULL;
+}
+
+void positionsDestroy(Positions **pPositions) {
+	Positions *positions = *pPositions;
+	free(positions->keys);
+	free(positions->slots);
+	free(positions);
+	*pPositions = NULL;
+}
+
+void positionsAppend(Positions *positions, void *key) {
+	const size_t slot = findSlot(positions, key);
+	assert(positions->length < positions->maxLength);
+	assert(positions->slots[slot] == EMPTY);
+	positions->keys[positions->length] = key;
+	positions->slots[slot] = positions->length;
+	++positions->length;
+}
+
+size_t positionsCount(const Positions *positions) {
+	return positions->length;
+}
+
+size_t positionsFind(const Positions *positions, const void *key) {
+	return positions->slots[findSlot(positions, key)];
+}
+
+void *positionsGet(const Positions *positions, size_t position) {
+	assert(position < positions->length);
+	return positions->keys[position];
+}
+
+//! @cond
+static size_t hash(const void *key, size_t slotCount) {
+	return (size_t) ((uint64_t) (uintptr_t) key * UINT64_C(0x9E3779B97F4A7C15) >> 32) & (slotCount - 1);
+}
+
+// the slot holding the item, or the empty slot where it would be inserted
+static size_t findSlot(const Positions *positions, const void *key) {
+	const size_t mask = positions->slotCount - 1;
+	size_t slot = hash(key, positions->slotCount);
+	while (positions->slots[slot] != EMPTY && positions->keys[positions->slots[slot]] != key)
+		slot = (slot + 1) & mask;
+	return slot;
+}
+//! @endcond
@@ -0,0 +1,24 @@
+/** @file
+ * Interface for an index of the positions of items in a fixed sequence.
+ */
+
+#ifndef MAP_POSITIONS_H
+#define MAP_POSITIONS_H
+
+#include <stdbool.h>
+#include "global_declarations.h"
+
+/// get the number of items in the sequence
+size_t positionsCount(const Positions *positions);
+/// get the position of an item, SIZE_MAX if it isn't in the sequence
+size_t positionsFind(const Positions *positions, const void *key);
+/// add an item at the end of the sequence, there has to be space for it
+void positionsAppend(Positions *positions, void *key);
+/// destroy the structure
+void positionsDestroy(Positions **pPositions);
+/// get the item at a position
+void *positionsGet(const Positions *positions, size_t position);
+/// create an empty sequence with space for a number of items
+Positions *positionsInit(size_t maxLength);
+
+#endif //MAP_POSITIONS_H
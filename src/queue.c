@@ -1,140 +1,364 @@
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include "queue.h"
 
-/// A node of the priority queue
-typedef struct Node Node;
+#define ARITY 4
+#define INIT_SPACE 8
+#define NOT_QUEUED SIZE_MAX
+#define YEAR_BITS 32
 
 
 /** A priority queue implementation.
- * Uses a heap to implement the priority queue. Needed for graph search
- * operations.
+ * Needed for graph search operations. Every city is in the queue at most
+ * once, its position is looked up by id when its key improves. There are
+ * two engines, chosen when the queue is prepared for a search.
+ *
+ * The heap engine is an indexed 4-ary heap. The order is kept in a dense
+ * array of 64-bit keys holding the distance in the high bits and the year,
+ * turned upside down, in the low ones. Once a distance doesn't fit, the
+ * queue switches to keys made of the distance alone and keeps the years in
+ * a separate array.
+ *
+ * The bucket engine is used when roads are short. Distances taken from the
+ * queue never decrease and the queued ones never exceed the last distance
+ * taken by more than the longest road, so a ring of that many lists, one per
+ * distance, holds all queued cities. Their keys are indexed by city id.
  */
 struct Heap {
-	/// list of nodes
-	Node *v;
+	/// keys of the nodes, the root is at index 0; indexed by id for buckets
+	uint64_t *keys;
+	/// years of the nodes if the keys are wide or the engine uses buckets
+	uint32_t *ties;
+	/// cities queued, in the same order as keys
+	City **cities;
+	/// ids of the cities queued, in the same order as keys
+	size_t *ids;
+	/// positions of the cities in the heap or their buckets, indexed by id
+	size_t *positions;
+	/// next city in the same bucket, indexed by id
+	size_t *next;
+	/// previous city in the same bucket, indexed by id
+	size_t *previous;
+	/// first cities of the buckets, NOT_QUEUED if a bucket is empty
+	size_t *buckets;
+	/// number of buckets in use, 0 if the heap engine is in use
+	size_t bucketCount;
+	/// number of buckets available
+	size_t bucketMax;
+	/// the lowest distance that may still be in a bucket
+	size_t cursor;
 	/// current size of the heap
 	size_t size;
 	/// total number of records available to the heap
 	size_t sizeMax;
+	/// true if the keys hold distances only
+	bool wide;
 };
-//! @cond
-struct Node {
-	/// last city reached
-	City *city;
-	/// last road used on the path to that node
-	Road *last;
-	/// minimum year on the path represented by the node
-	int minYear;
-	int pad;
-	/// the weight of the node
-	size_t s;
-};
-//! @endcond
 
 // auxiliary function declarations
-bool queueAdjust(Heap *heap);
-bool greater(const Heap *heap, size_t lhs, size_t rhs);
-
-size_t left(size_t x);
-size_t parent(size_t x);
-size_t right(size_t x);
+static bool before(uint64_t key1, uint32_t tie1, uint64_t key2, uint32_t tie2);
+static bool grow(Heap *heap, size_t newMax);
+static bool growBuckets(Heap *heap, size_t count);
+static uint32_t packYear(int minYear);
+static int unpackYear(uint32_t year);
+static void bucketAdd(Heap *heap, size_t cityId, size_t distance);
+static void bucketRemove(Heap *heap, size_t cityId);
+static void place(Heap *heap, size_t i, uint64_t key, uint32_t tie, City *city, size_t cityId);
+static void siftDown(Heap *heap, size_t i);
+static void siftUp(Heap *heap, size_t i, uint64_t key, uint32_t tie, City *city, size_t cityId);
+static void widen(Heap *heap);
+static size_t firstBucket(Heap *heap);
+static City *popBucket(Heap *heap, size_t *cityId, size_t *distance, int *minYear);
 
 // linked function definitions
 bool queueEmpty(const Heap *heap) {
 	return heap->size == 0;
 }
 
-bool queuePush(Heap *heap, Road *road, City *city, size_t distance, int minYear) {
-	bool adjustSuccess = queueAdjust(heap);
-	Node *arr = heap->v;
-	if (!adjustSuccess)
-		return false;
-	++heap->size;
-	arr[heap->size] = (Node) {.city = city, .s = distance, .minYear = minYear, .last = road};
-	for (size_t i = heap->size; true; i = parent(i)) {
-		if (greater(heap, i, parent(i)))
-			break;
-		Node temp = heap->v[i];
-		heap->v[i] = heap->v[parent(i)];
-		heap->v[parent(i)] = temp;
+void queueClear(Heap *heap) {
+	if (heap->bucketCount) {
+		for (size_t i = 0; heap->size > 0; ++i) {
+			size_t *bucket = &heap->buckets[i % heap->bucketCount];
+			for (; *bucket != NOT_QUEUED; --heap->size)
+				bucketRemove(heap, *bucket);
+		}
+	}
+	for (size_t i = 0; i < heap->size; ++i)
+		heap->positions[heap->ids[i]] = NOT_QUEUED;
+	heap->size = 0;
+	heap->wide = false;
+	heap->cursor = 0;
+}
+
+bool queuePrepare(Heap *heap, size_t cityCount, unsigned maxLength) {
+	queueClear(heap);
+	heap->bucketCount = 0;
+	if (cityCount > heap->sizeMax) {
+		size_t newMax = heap->sizeMax;
+		while (newMax < cityCount)
+			newMax *= 2;
+		if (!grow(heap, newMax))
+			return false;
 	}
-	assert(heap->v[1].city);
+	// a failure to make the buckets only means that the heap is used
+	if (maxLength <= QUEUE_BUCKET_LIMIT && growBuckets(heap, (size_t) maxLength + 1))
+		heap->bucketCount = (size_t) maxLength + 1;
 	return true;
 }
 
-Road *queuePop(Heap *heap, size_t *distance, int *minYear, City **pCity) {
-	Node *arr = heap->v, ans;
-	size_t temp;
-	ans = arr[1];
-	temp = heap->size;
-	for (size_t i = 1, next; true; i = next) {
-		if (greater(heap, left(i), temp) && greater(heap, right(i), temp)) {
-			arr[i] = arr[heap->size];
-			break;
-		}
-		next = (greater(heap, left(i), right(i)) ? right : left)(i);
-		arr[i] = arr[next];
+void queueStart(Heap *heap, size_t distance) {
+	assert(heap->size == 0);
+	heap->cursor = distance;
+}
+
+void queueUpdate(Heap *heap, City *city, size_t cityId, size_t distance, int minYear) {
+	assert(cityId < heap->sizeMax);
+	if (heap->bucketCount) {
+		assert(distance >= heap->cursor && distance - heap->cursor < heap->bucketCount);
+		if (heap->positions[cityId] == NOT_QUEUED)
+			++heap->size;
+		else if (heap->keys[cityId] != distance)
+			bucketRemove(heap, cityId);
+		if (heap->positions[cityId] == NOT_QUEUED)
+			bucketAdd(heap, cityId, distance);
+		heap->keys[cityId] = distance;
+		heap->ties[cityId] = packYear(minYear);
+		heap->cities[cityId] = city;
+		return;
+	}
+	if (!heap->wide && distance >> (64 - YEAR_BITS))
+		widen(heap);
+	uint64_t key;
+	uint32_t tie;
+	if (heap->wide) {
+		key = distance;
+		tie = packYear(minYear);
+	} else {
+		key = (uint64_t) distance << YEAR_BITS | packYear(minYear);
+		tie = 0;
+	}
+	size_t i = heap->positions[cityId];
+	if (i == NOT_QUEUED) {
+		assert(heap->size < heap->sizeMax);
+		i = heap->size++;
+	} else {
+		assert(!before(heap->keys[i], heap->ties[i], key, tie));
+	}
+	siftUp(heap, i, key, tie, city, cityId);
+}
+
+City *queuePop(Heap *heap, size_t *distance, int *minYear) {
+	size_t cityId;
+	return queuePopId(heap, &cityId, distance, minYear);
+}
+
+City *queuePopId(Heap *heap, size_t *cityId, size_t *distance, int *minYear) {
+	assert(heap->size > 0);
+	if (heap->bucketCount)
+		return popBucket(heap, cityId, distance, minYear);
+	const uint64_t key = heap->keys[0];
+	City *ans = heap->cities[0];
+	*cityId = heap->ids[0];
+	if (heap->wide) {
+		*distance = (size_t) key;
+		*minYear = unpackYear(heap->ties[0]);
+	} else {
+		*distance = (size_t) (key >> YEAR_BITS);
+		*minYear = unpackYear((uint32_t) key);
 	}
-	assert(heap->size == 0 || heap->v[1].city != NULL);
+	heap->positions[heap->ids[0]] = NOT_QUEUED;
 	--heap->size;
-	*distance = ans.s;
-	*minYear = ans.minYear;
-	*pCity = ans.city;
-	return ans.last;
+	if (heap->size > 0)
+		siftDown(heap, 0);
+	return ans;
+}
+
+size_t queueTop(Heap *heap) {
+	assert(heap->size > 0);
+	if (heap->bucketCount)
+		return firstBucket(heap);
+	return (size_t) (heap->wide ? heap->keys[0] : heap->keys[0] >> YEAR_BITS);
 }
 
 Heap *queueInit() {
-	Heap *ans = malloc(sizeof(Heap));
+	Heap *ans = calloc(1, sizeof(Heap));
 	if (ans) {
-		*ans = (Heap) {.size = 0, .sizeMax = 8};
-		ans->v = malloc(ans->sizeMax * sizeof(Node));
-		if (ans->v)
+		if (grow(ans, INIT_SPACE))
 			return ans;
-		free(ans);
+		queueDestroy(&ans);
 	}
 	return NULL;
 }
 
 void queueDestroy(Heap **pHeap) {
-	free((*pHeap)->v);
-	free(*pHeap);
+	Heap *heap = *pHeap;
+	free(heap->keys);
+	free(heap->ties);
+	free(heap->cities);
+	free(heap->ids);
+	free(heap->positions);
+	free(heap->next);
+	free(heap->previous);
+	free(heap->buckets);
+	free(heap);
 	*pHeap = NULL;
 }
 
 // auxiliary function definitions
-bool queueAdjust(Heap *heap) {
-	assert(heap && (heap->sizeMax > heap->size));
-	if (heap->sizeMax > heap->size + 1)
-		return true;
-	Node *tmp = realloc(heap->v, 2 * heap->sizeMax * sizeof(Node));
-	if (tmp) {
-		heap->v = tmp;
-		heap->sizeMax *= 2;
-		return true;
-	} else {
+static bool grow(Heap *heap, size_t newMax) {
+	uint64_t *keys = realloc(heap->keys, newMax * sizeof(uint64_t));
+	if (keys == NULL)
+		return false;
+	heap->keys = keys;
+	uint32_t *ties = realloc(heap->ties, newMax * sizeof(uint32_t));
+	if (ties == NULL)
+		return false;
+	heap->ties = ties;
+	City **cities = realloc(heap->cities, newMax * sizeof(City *));
+	if (cities == NULL)
+		return false;
+	heap->cities = cities;
+	size_t *ids = realloc(heap->ids, newMax * sizeof(size_t));
+	if (ids == NULL)
+		return false;
+	heap->ids = ids;
+	size_t *next = realloc(heap->next, newMax * sizeof(size_t));
+	if (next == NULL)
+		return false;
+	heap->next = next;
+	size_t *previous = realloc(heap->previous, newMax * sizeof(size_t));
+	if (previous == NULL)
 		return false;
+	heap->previous = previous;
+	size_t *positions = realloc(heap->positions, newMax * sizeof(size_t));
+	if (positions == NULL)
+		return false;
+	for (size_t i = heap->sizeMax; i < newMax; ++i)
+		positions[i] = NOT_QUEUED;
+	heap->positions = positions;
+	heap->sizeMax = newMax;
+	return true;
+}
+
+static bool growBuckets(Heap *heap, size_t count) {
+	if (count > heap->bucketMax) {
+		size_t *tmp = realloc(heap->buckets, count * sizeof(size_t));
+		if (tmp == NULL)
+			return false;
+		for (size_t i = heap->bucketMax; i < count; ++i)
+			tmp[i] = NOT_QUEUED;
+		heap->buckets = tmp;
+		heap->bucketMax = count;
 	}
+	return true;
 }
 
-bool greater(const Heap *heap, size_t lhs, size_t rhs) {
-	if (lhs > heap->size || rhs > heap->size || rhs < 1 || lhs < 1)
-		return lhs > heap->size || rhs < 1;
-	Node *lNode = &heap->v[lhs], *rNode = &heap->v[rhs];
-	if (lNode->s == rNode->s)
-		return (lNode->minYear < rNode->minYear);
-	else
-		return lNode->s > rNode->s;
+// higher years come first, so they are stored upside down
+static uint32_t packYear(int minYear) {
+	assert(minYear <= INT16_MAX);
+	return (uint32_t) (INT16_MAX - (int64_t) minYear);
 }
 
-size_t left(size_t x) {
-	return x * 2;
+static int unpackYear(uint32_t year) {
+	return (int) (INT16_MAX - (int64_t) year);
 }
 
-size_t parent(size_t x) {
-	return x / 2;
+// the order of the nodes doesn't change, so the heap stays valid
+static void widen(Heap *heap) {
+	for (size_t i = 0; i < heap->size; ++i) {
+		heap->ties[i] = (uint32_t) heap->keys[i];
+		heap->keys[i] >>= YEAR_BITS;
+	}
+	heap->wide = true;
+}
+
+static bool before(uint64_t key1, uint32_t tie1, uint64_t key2, uint32_t tie2) {
+	return key1 < key2 || (key1 == key2 && tie1 < tie2);
+}
+
+static void place(Heap *heap, size_t i, uint64_t key, uint32_t tie, City *city, size_t cityId) {
+	heap->keys[i] = key;
+	heap->ties[i] = tie;
+	heap->cities[i] = city;
+	heap->ids[i] = cityId;
+	heap->positions[cityId] = i;
+}
+
+static void siftUp(Heap *heap, size_t i, uint64_t key, uint32_t tie, City *city, size_t cityId) {
+	while (i > 0) {
+		size_t parent = (i - 1) / ARITY;
+		if (!before(key, tie, heap->keys[parent], heap->ties[parent]))
+			break;
+		place(heap, i, heap->keys[parent], heap->ties[parent], heap->cities[parent], heap->ids[parent]);
+		i = parent;
+	}
+	place(heap, i, key, tie, city, cityId);
 }
 
-size_t right(size_t x) {
-	return 1 + x * 2;
+// moves the last node into the hole at position i
+static void siftDown(Heap *heap, size_t i) {
+	const size_t size = heap->size;
+	const uint64_t *keys = heap->keys;
+	const uint32_t *ties = heap->ties;
+	const uint64_t key = keys[size];
+	const uint32_t tie = ties[size];
+	City *const city = heap->cities[size];
+	const size_t cityId = heap->ids[size];
+	for (size_t first = ARITY * i + 1; first < size; first = ARITY * i + 1) {
+		size_t best = first;
+		const size_t end = (first + ARITY < size ? first + ARITY : size);
+		for (size_t child = first + 1; child < end; ++child) {
+			if (before(keys[child], ties[child], keys[best], ties[best]))
+				best = child;
+		}
+		if (!before(keys[best], ties[best], key, tie))
+			break;
+		place(heap, i, keys[best], ties[best], heap->cities[best], heap->ids[best]);
+		i = best;
+	}
+	place(heap, i, key, tie, city, cityId);
+}
+
+static void bucketAdd(Heap *heap, size_t cityId, size_t distance) {
+	size_t bucket = distance % heap->bucketCount;
+	size_t first = heap->buckets[bucket];
+	heap->next[cityId] = first;
+	heap->previous[cityId] = NOT_QUEUED;
+	if (first != NOT_QUEUED)
+		heap->previous[first] = cityId;
+	heap->buckets[bucket] = cityId;
+	heap->positions[cityId] = bucket;
+}
+
+static void bucketRemove(Heap *heap, size_t cityId) {
+	size_t next = heap->next[cityId], previous = heap->previous[cityId];
+	if (previous == NOT_QUEUED)
+		heap->buckets[heap->positions[cityId]] = next;
+	else
+		heap->next[previous] = next;
+	if (next != NOT_QUEUED)
+		heap->previous[next] = previous;
+	heap->positions[cityId] = NOT_QUEUED;
+}
+
+// moves the cursor to the lowest distance queued
+static size_t firstBucket(Heap *heap) {
+	while (heap->buckets[heap->cursor % heap->bucketCount] == NOT_QUEUED)
+		++heap->cursor;
+	return heap->cursor;
+}
+
+/* cities with the same distance leave in no particular order, a search
+ * doesn't settle a city before all the closer ones, which is all it needs
+ */
+static City *popBucket(Heap *heap, size_t *cityId, size_t *distance, int *minYear) {
+	firstBucket(heap);
+	*cityId = heap->buckets[heap->cursor % heap->bucketCount];
+	bucketRemove(heap, *cityId);
+	--heap->size;
+	*distance = heap->keys[*cityId];
+	*minYear = unpackYear(heap->ties[*cityId]);
+	assert(*distance == heap->cursor);
+	return heap->cities[*cityId];
 }
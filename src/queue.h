@@ -8,14 +8,27 @@
 #include <stdbool.h>
 #include "global_declarations.h"
 
+/// the longest road for which the queue is made of buckets instead of a heap
+#define QUEUE_BUCKET_LIMIT 1024
+
+/// remove all records from the queue
+void queueClear(Heap *heap);
 /// check if a queue is empty
 bool queueEmpty(const Heap *heap);
-/// add a record to the queue
-bool queuePush(Heap *heap, Road *road, City *city, size_t distance, int minYear);
+/// empty the queue and choose its engine for a search in a map
+bool queuePrepare(Heap *heap, size_t cityCount, unsigned maxLength);
+/// make an empty queue start at a distance, no lower one may be added
+void queueStart(Heap *heap, size_t distance);
+/// add a city to the queue, or move it forward if it is already there
+void queueUpdate(Heap *heap, City *city, size_t cityId, size_t distance, int minYear);
+/// get the lowest distance in a queue that isn't empty
+size_t queueTop(Heap *heap);
 /// initialize a queue
 Heap *queueInit(void);
-/// take a record from the queue
-Road *queuePop(Heap *heap, size_t *distance, int *minYear, City **pCity);
+/// take a city with the lowest distance, the heap engine prefers higher years
+City *queuePop(Heap *heap, size_t *distance, int *minYear);
+/// take a city with the lowest distance along with the id it was added with
+City *queuePopId(Heap *heap, size_t *cityId, size_t *distance, int *minYear);
 /// destroy a queue
 void queueDestroy(Heap **pHeap);
 
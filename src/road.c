@@ -1,10 +1,13 @@
 #include "city.h"
 #include "map.h"
 #include "road.h"
+#include "route_set.h"
+#include "route_table.h"
 #include "trie.h"
 #include "trunk.h"
 
 #define ROAD_MAP_LENGTH 32
+#define SLAB_LENGTH 256
 
 /// Stores information about a road
 struct Road {
@@ -16,45 +19,39 @@ struct Road {
 	int year;
 	/// the length of the road
 	unsigned length;
-	/// number of Routes using the road
-	unsigned routeCount;
-	/// explicit struct padding
-	unsigned pad;
-	/** integer -> bool map, informing whether a Route with a given id uses the
-	 * road. Initialized with NULL (equivalent of empty map) to save space.
-	 */
-	bool *routes;
+	/// ids of the Routes using the road
+	RouteSet routes;
 };
 
 /** Contains all roads from a map structure.
  * Allows to hide information about roads from code that doesn't
- * need to use it.
+ * need to use it. The roads are stored in slabs of SLAB_LENGTH records,
+ * filled in the order of creation, so a road never changes its address.
  */
 struct RoadMap {
-	/// all roads of the map
-	Road **roads;
+	/// slabs holding the roads of the map
+	Road **slabs;
 	/// number of existing roads
 	size_t length;
-	/// number of records available for storing roads
-	size_t maxLength;
+	/// number of allocated slabs
+	size_t slabCount;
+	/// number of records available for storing slabs
+	size_t maxSlabCount;
 };
 
-static bool add(RoadMap *roadMap, Road *road);
+static bool addSlab(RoadMap *roadMap);
 static bool adjust(RoadMap *roadMap);
 static bool testCount(const Road *road);
 static void removeLast(RoadMap *roadMap);
+static Road *roadAt(const RoadMap *roadMap, size_t index);
 static Road *roadInit(RoadMap *roadMap);
 
-#ifndef NDEBUG
-static bool checkDestroyed(const Road *road, Trunk *trunks[ROUTE_LIMIT]);
-#endif // NDEBUG
+bool roadReserve(Road *road, unsigned extra) {
+	return routeSetReserve(&road->routes, extra);
+}
 
-bool roadReserve(Road *road) {
-	if (road->routes == NULL) {
-		road->routes = calloc(ROUTE_LIMIT, sizeof(bool));
-		return road->routes != NULL;
-	}
-	return true;
+const RouteSet *roadGetRoutes(const Road *road) {
+	return &road->routes;
 }
 
 unsigned roadGetLength(const Road *road) {
@@ -62,7 +59,7 @@ unsigned roadGetLength(const Road *road) {
 }
 
 unsigned roadRouteCount(const Road *road) {
-	return road->routeCount;
+	return routeSetCount(&road->routes);
 }
 
 bool roadLoneRoad(CityMap *cityMap, Trie *trie, RoadInfo roadInfo) {
@@ -83,13 +80,12 @@ bool roadLoneRoad(CityMap *cityMap, Trie *trie, RoadInfo roadInfo) {
 				bool successAdd = trieAddFromList(trie, list, cities);
 				if (successAdd)
 					return true;
-				roadFree(&road);
 			}
 			free(cities[1]);
 		}
 		free(cities[0]);
 	}
-	free(road);
+	removeLast(roadInfo.roadMap);
 	return false;
 }
 
@@ -101,11 +97,7 @@ bool roadInitFields(Road *road, RoadInfo info, City *city1, City *city2) {
 		.city2 = city2,
 		.year = info.builtYear,
 		.length = info.length,
-		.routeCount = 0,
-		.routes = calloc(ROUTE_LIMIT, sizeof(bool))
 	};
-	if (!road->routes)
-		return false;
 	return true;
 }
 
@@ -129,17 +121,7 @@ void roadGetCities(Road *road, City **city1, City **city2) {
 }
 
 void roadTrunkRemove(Road *road, unsigned trunkId) {
-	assert(road->routes && road->routes[trunkId]);
-	road->routes[trunkId] = false;
-	--road->routeCount;
-}
-
-void roadFree(Road **pRoad) {
-	Road *road = *pRoad;
-	assert(!cityFindRoad(road->city1, road->city2));
-	*pRoad = NULL;
-	free(road->routes);
-	free(road);
+	routeSetRemove(&road->routes, trunkId);
 }
 
 bool roadExtend(CityMap *m, Trie *t, City *city, RoadInfo info) {
@@ -161,7 +143,7 @@ bool roadExtend(CityMap *m, Trie *t, City *city, RoadInfo info) {
 			}
 			cityDestroy(&newCity);
 		}
-		free(road);
+		removeLast(info.roadMap);
 	}
 	return false;
 }
@@ -177,7 +159,7 @@ bool roadLink(RoadMap *roadMap, City *city1, City *city2, unsigned length, int y
 			r->city2 = (city1 < city2 ? city2 : city1);
 			return true;
 		}
-		free(r);
+		removeLast(roadMap);
 	}
 	return false;
 }
@@ -193,17 +175,6 @@ bool roadUpdate(Road *road, int year) {
 	return ans;
 }
 
-void roadDestroyTrunks(Trunk *trunks[ROUTE_LIMIT], Road *road) {
-	for (size_t i = 0; i< ROUTE_LIMIT; ++i) {
-		if (road->routes[i])
-			trunkFree(&trunks[i]);
-	}
-	road->routeCount = 0;
-	assert(checkDestroyed(road, trunks));
-	free(road->routes);
-	road->routes = NULL;
-}
-
 long roadWrite(char *str, const Road *road, const City *city) {
 	long ans;
 	ans = sprintf(str, ";%u;%i;", road->length, road->year);
@@ -213,18 +184,7 @@ long roadWrite(char *str, const Road *road, const City *city) {
 }
 
 void roadTrunkAdd(Road *road, unsigned trunkId) {
-	assert(road->routes);
-	if (road->routes[trunkId])
-		return;
-	++road->routeCount;
-	road->routes[trunkId] = true;
-}
-
-void roadUnblock(Road *road, unsigned length) {
-	assert(roadGetLength(road) == (unsigned) -1);
-	cityBlock(road->city1);
-	cityBlock(road->city2);
-	road->length = length;
+	routeSetAdd(&road->routes, trunkId);
 }
 
 void roadDetach(Road *road, const City *city) {
@@ -249,27 +209,25 @@ bool roadHasCity(const Road *road, const City *city) {
 		return false;
 }
 
-unsigned roadBlock(Road *road) {
-	cityUnblock(road->city1);
-	cityUnblock(road->city2);
-	unsigned ans = road->length;
-	road->length = (unsigned) -1;
-	return ans;
-}
-
-bool roadMoveTrunks(CityMap *cityMap, Trunk *trunks[ROUTE_LIMIT], Road *road) {
-	Trunk **replacements = rebuildTrunks(cityMap, road, trunks);
+bool roadMoveTrunks(CityMap *cityMap, RouteTable *trunks, Road *road, Search *search) {
+	Trunk **replacements = rebuildTrunks(cityMap, road, trunks, search);
 	const unsigned routeCount = roadRouteCount(road);
 	if (!replacements)
 		return false;
-	roadDestroyTrunks(trunks, road);
+	// detours of different Routes may share roads
+	if (!trunkReserveAll(replacements, routeCount)) {
+		for (size_t j = 0; j < routeCount; ++j)
+			trunkFree(&replacements[j]);
+		free(replacements);
+		return false;
+	}
 	for (size_t i = 0; i < routeCount; ++i) {
-		trunkAttach(replacements[i]);
+		Trunk *old = routeTableReplace(trunks, replacements[i]);
+		trunkFree(&old);
 	}
+	routeSetClear(&road->routes);
 	for (size_t i = 0; i < routeCount; ++i) {
-		Trunk **trunk = &trunks[trunkGetId(replacements[i])];
-		assert(*trunk == NULL);
-		*trunk = replacements[i];
+		trunkAttach(replacements[i]);
 	}
 	free(replacements);
 	return true;
@@ -280,10 +238,11 @@ RoadMap *roadMapInit(void) {
 	if (ans) {
 		*ans = (RoadMap) {
 			.length = 0,
-			.maxLength = ROAD_MAP_LENGTH,
-			.roads = calloc(ROAD_MAP_LENGTH, sizeof(Road *)),
+			.slabCount = 0,
+			.maxSlabCount = ROAD_MAP_LENGTH,
+			.slabs = calloc(ROAD_MAP_LENGTH, sizeof(Road *)),
 		};
-		if (ans->roads)
+		if (ans->slabs)
 			return ans;
 		free(ans);
 	}
@@ -294,18 +253,17 @@ size_t roadMapGetLength(const RoadMap *roadMap) {
 	return roadMap->length;
 }
 
+Road *roadMapGet(const RoadMap *roadMap, size_t index) {
+	return roadAt(roadMap, index);
+}
+
 void roadMapDestroy(RoadMap **pRoadMap) {
 	RoadMap *temp = *pRoadMap;
-	for (size_t i = 0; i < temp->length; ++i) {
-		Road *road = temp->roads[i];
-		temp->roads[i] = NULL;
-		if (road->routes != NULL) {
-			free(road->routes);
-			road->routes = NULL;
-		}
-		free(road);
-	}
-	free(temp->roads);
+	for (size_t i = 0; i < temp->length; ++i)
+		routeSetClear(&roadAt(temp, i)->routes);
+	for (size_t i = 0; i < temp->slabCount; ++i)
+		free(temp->slabs[i]);
+	free(temp->slabs);
 	free(*pRoadMap);
 	*pRoadMap = NULL;
 }
@@ -318,13 +276,11 @@ void roadMapTrim(RoadMap *roadMap, size_t length) {
 		removeLast(roadMap);
 }
 
-bool roadMapTestTrunk(const RoadMap *roadMap, const bool *trunks) {
+bool roadMapTestTrunk(const RoadMap *roadMap, const RouteTable *trunks) {
 	for (size_t i = 0; i < roadMap->length; ++i) {
-		Road *road = roadMap->roads[i];
-		if (road->routes == NULL)
-			continue;
-		for (size_t j = 0; j < ROUTE_LIMIT; ++j) {
-			if (road->routes[j] && !trunks[j]) {
+		const RouteSet *routes = &roadAt(roadMap, i)->routes;
+		for (unsigned j = 0; j < routeSetCount(routes); ++j) {
+			if (!routeTableFind(trunks, routeSetGet(routes, j))) {
 				return false;
 			}
 		}
@@ -333,28 +289,20 @@ bool roadMapTestTrunk(const RoadMap *roadMap, const bool *trunks) {
 }
 
 bool roadHasRoute(const Road *road, unsigned routeId) {
-	return road->routes[routeId];
+	return routeSetHas(&road->routes, routeId);
 }
 
 bool roadMapTestCount(const RoadMap *roadMap) {
 	for (size_t i = 0; i < roadMap->length; ++i) {
-		if (!testCount(roadMap->roads[i])) {
+		if (!testCount(roadAt(roadMap, i))) {
 			return false;
 		}
 	}
 	return true;
 }
 
-void roadGetIds(const Road *road, unsigned *result) {
-	for (unsigned i = 0, j = 0; i < ROUTE_LIMIT; ++i) {
-		assert(i < ROUTE_LIMIT);
-		if (roadHasRoute(road, i)) {
-			result[j] = i;
-			++j;
-		} else {
-			result[ROUTE_LIMIT - i + j - 1] = 0;
-		}
-	}
+unsigned roadGetRoute(const Road *road, unsigned index) {
+	return routeSetGet(&road->routes, index);
 }
 
 bool roadHasIntersection(const Road *road1, const Road *road2) {
@@ -365,73 +313,55 @@ bool roadHasIntersection(const Road *road1, const Road *road2) {
 
 static bool adjust(RoadMap *roadMap) {
 	assert(roadMap);
-	size_t newMax = 2 * roadMap->maxLength;
-	Road **temp = realloc(roadMap->roads, newMax * sizeof(Road *));
+	size_t newMax = 2 * roadMap->maxSlabCount;
+	Road **temp = realloc(roadMap->slabs, newMax * sizeof(Road *));
 	if (temp) {
-		roadMap->maxLength = newMax;
-		roadMap->roads = temp;
+		roadMap->maxSlabCount = newMax;
+		roadMap->slabs = temp;
 		return true;
 	}
 	return false;
 }
 
-static bool add(RoadMap *roadMap, Road *road) {
-	size_t length = roadMap->length;
-
-	if (length == roadMap->maxLength) {
+static bool addSlab(RoadMap *roadMap) {
+	if (roadMap->slabCount == roadMap->maxSlabCount) {
 		bool adjustSuccess = adjust(roadMap);
 		if (!adjustSuccess)
 			return false;
 	}
-	assert(length < roadMap->maxLength);
-
-	roadMap->roads[length] = road;
-	roadMap->length = length + 1;
+	assert(roadMap->slabCount < roadMap->maxSlabCount);
+	Road *slab = malloc(SLAB_LENGTH * sizeof(Road));
+	if (slab == NULL)
+		return false;
+	roadMap->slabs[roadMap->slabCount++] = slab;
 	return true;
 }
 
+static Road *roadAt(const RoadMap *roadMap, size_t index) {
+	assert(index < roadMap->length);
+	return &roadMap->slabs[index / SLAB_LENGTH][index % SLAB_LENGTH];
+}
+
 static Road *roadInit(RoadMap *roadMap) {
-	Road *ans = malloc(sizeof(Road));
-	if (ans) {
-		bool addSuccess = add(roadMap, ans);
-		if (addSuccess)
-			return ans;
-		free(ans);
+	if (roadMap->length == roadMap->slabCount * SLAB_LENGTH) {
+		bool addSuccess = addSlab(roadMap);
+		if (!addSuccess)
+			return NULL;
 	}
-	return NULL;
+	Road *ans = &roadMap->slabs[roadMap->length / SLAB_LENGTH][roadMap->length % SLAB_LENGTH];
+	++roadMap->length;
+	*ans = (Road) {.city1 = NULL, .city2 = NULL};
+	return ans;
 }
 
+// the slabs are kept, they will be reused by the roads created next
 static void removeLast(RoadMap *roadMap) {
-	Road **pLast = &roadMap->roads[roadMap->length - 1];
-	Road *last = *pLast;
+	Road *last = roadAt(roadMap, roadMap->length - 1);
 	assert(roadRouteCount(last) == 0);
-	if (last->routes) {
-		free(last->routes);
-		last->routes = NULL;
-	}
-	free(last);
-	*pLast = NULL;
+	routeSetClear(&last->routes);
 	--roadMap->length;
 }
 
-// function used only in assertions
-#ifndef NDEBUG
-bool checkDestroyed(const Road *road, Trunk *trunks[ROUTE_LIMIT]) {
-	for (unsigned i = 0; i < ROUTE_LIMIT; ++i) {
-		if (roadHasRoute(road, i) && trunks[i])
-			return false;
-	}
-	return true;
-}
-#endif // NDEBUG
-
 static bool testCount(const Road *road) {
-	for (unsigned i = 1, count = 0; true; ++i) {
-		if (count == roadRouteCount(road))
-			return true;
-		if (i == ROUTE_LIMIT)
-			return false;
-		if (roadHasRoute(road, i))
-			++count;
-	}
+	return routeSetTest(&road->routes) && !roadHasRoute(road, 0);
 }
@@ -26,45 +26,41 @@ bool roadInitFields(Road *road, RoadInfo info, City *city1, City *city2);
 /// connect two existing cities with a road
 bool roadLink(RoadMap *roadMap, City *city1, City *city2, unsigned length, int year);
 /// find a detour for every Route using this road
-bool roadMoveTrunks(CityMap *cityMap, Trunk *trunks[ROUTE_LIMIT], Road *road);
-/// prepare a road for holding information about the Routes using it
-bool roadReserve(Road *road);
+bool roadMoveTrunks(CityMap *cityMap, RouteTable *trunks, Road *road, Search *search);
+/// prepare a road for holding information about more Routes using it
+bool roadReserve(Road *road, unsigned extra);
 /// repair a road
 bool roadUpdate(Road *road, int year);
 /// get the year of a road's last repair or construction
 int roadGetYear(const Road *road);
 /// append a road's description to a string
 long roadWrite(char *str, const Road *road, const City *city);
-/// make a road invalid for searches performed on the map
-unsigned roadBlock(Road *road);
+/// get the id of a Route using the road, ids are sorted in ascending order
+unsigned roadGetRoute(const Road *road, unsigned index);
 /// get the Route count of a road
 unsigned roadRouteCount(const Road *road);
+/// get the ids of the Routes using the road
+const RouteSet *roadGetRoutes(const Road *road);
 /// get the length of a road
 unsigned roadGetLength(const Road *road);
-/// destroy all Routes through a given road
-void roadDestroyTrunks(Trunk *trunks[ROUTE_LIMIT], Road *road);
 /// remove a road from the records of adjacent cities
 void roadDetach(Road *road, const City *city);
-/// destroy a road
-void roadFree(Road **pRoad);
 /// get cities on both ends of road
 void roadGetCities(Road *road, City **city1, City **city2);
-/// get ids of all trunks using the road
-void roadGetIds(const Road *road, unsigned *result);
 /// add a road to a Route
 void roadTrunkAdd(Road *road, unsigned trunkId);
 /// remove a road from a Route
 void roadTrunkRemove(Road *road, unsigned trunkId);
-/// make a road valid for searches performed on the map
-void roadUnblock(Road *road, unsigned length);
 /// find a city shared by two roads
 City *roadIntersect(Road *road1, Road *road2);
 /// debug function, check invariant related to road usage by Routes
 bool roadMapTestCount(const RoadMap *roadMap);
 /// debug function, check trunk-related invariants in a road map
-bool roadMapTestTrunk(const RoadMap *roadMap, const bool *trunks);
+bool roadMapTestTrunk(const RoadMap *roadMap, const RouteTable *trunks);
 /// get the number of roads in a map
 size_t roadMapGetLength(const RoadMap *roadMap);
+/// get a road by its position in the order the roads were added
+Road *roadMapGet(const RoadMap *roadMap, size_t index);
 /// destroy a RoadMap structure
 void roadMapDestroy(RoadMap **pRoadMap);
 /// remove the most recently added roads
@@ -72,7 +68,7 @@ void roadMapTrim(RoadMap *roadMap, size_t length);
 /// initialize a RoadMap structure
 RoadMap *roadMapInit(void);
 /// create detours for all trunks affected by road removal
-Trunk **rebuildTrunks(CityMap *cityMap, Road *road, Trunk *trunks[ROUTE_LIMIT]);
+Trunk **rebuildTrunks(CityMap *cityMap, Road *road, const RouteTable *trunks, Search *search);
 
 
 #endif // MAP_ROAD_H
@@ -0,0 +1,110 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "route_set.h"
+
+//! @cond
+static unsigned *items(RouteSet *set);
+static const unsigned *constItems(const RouteSet *set);
+static unsigned lowerBound(const RouteSet *set, unsigned id);
+//! @endcond
+
+bool routeSetHas(const RouteSet *set, unsigned id) {
+	unsigned i = lowerBound(set, id);
+	return i < set->count && constItems(set)[i] == id;
+}
+
+bool routeSetReserve(RouteSet *set, unsigned extra) {
+	const unsigned needed = set->count + extra;
+	if (needed <= ROUTE_SET_INLINE || needed <= set->capacity)
+		return true;
+	unsigned capacity = 2 * (set->capacity ? set->capacity : ROUTE_SET_INLINE);
+	if (capacity < needed)
+		capacity = needed;
+	if (set->capacity) {
+		unsigned *tmp = realloc(set->array, capacity * sizeof(unsigned));
+		if (tmp == NULL)
+			return false;
+		set->array = tmp;
+	} else {
+		unsigned *tmp = malloc(capacity * sizeof(unsigned));
+		if (tmp == NULL)
+			return false;
+		memcpy(tmp, set->ids, set->count * sizeof(unsigned));
+		set->array = tmp;
+	}
+	set->capacity = capacity;
+	return true;
+}
+
+unsigned routeSetCount(const RouteSet *set) {
+	return set->count;
+}
+
+unsigned routeSetGet(const RouteSet *set, unsigned index) {
+	assert(index < set->count);
+	return constItems(set)[index];
+}
+
+void routeSetAdd(RouteSet *set, unsigned id) {
+	unsigned position = lowerBound(set, id);
+	unsigned *ids = items(set);
+	if (position < set->count && ids[position] == id)
+		return;
+	assert(set->count < (set->capacity ? set->capacity : ROUTE_SET_INLINE));
+	memmove(ids + position + 1, ids + position, (set->count - position) * sizeof(unsigned));
+	ids[position] = id;
+	++set->count;
+}
+
+void routeSetRemove(RouteSet *set, unsigned id) {
+	unsigned position = lowerBound(set, id);
+	unsigned *ids = items(set);
+	assert(position < set->count && ids[position] == id);
+	--set->count;
+	memmove(ids + position, ids + position + 1, (set->count - position) * sizeof(unsigned));
+	if (set->count == 0)
+		routeSetClear(set);
+}
+
+void routeSetClear(RouteSet *set) {
+	if (set->capacity)
+		free(set->array);
+	*set = (RouteSet) {.count = 0, .capacity = 0};
+}
+
+bool routeSetTest(const RouteSet *set) {
+	const unsigned *ids = constItems(set);
+	if (set->count > (set->capacity ? set->capacity : ROUTE_SET_INLINE))
+		return false;
+	for (unsigned i = 1; i < set->count; ++i) {
+		if (ids[i - 1] >= ids[i])
+			return false;
+	}
+	return true;
+}
+
+//! @cond
+static unsigned *items(RouteSet *set) {
+	return set->capacity ? set->array : set->ids;
+}
+
+static const unsigned *constItems(const RouteSet *set) {
+	return set->capacity ? set->array : set->ids;
+}
+
+// position of the first id not lower than the one given
+static unsigned lowerBound(const RouteSet *set, unsigned id) {
+	const unsigned *ids = constItems(set);
+	unsigned low = 0, high = set->count;
+	while (low < high) {
+		unsigned middle = low + (high - low) / 2;
+		if (ids[middle] < id)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low;
+}
+//! @endcond
@@ -0,0 +1,50 @@
+/** @file
+ * Interface for a compact set of Route ids, used to record which Routes go
+ * through a road.
+ */
+
+#ifndef MAP_ROUTE_SET_H
+#define MAP_ROUTE_SET_H
+
+#include <stdbool.h>
+#include "global_declarations.h"
+
+/// number of ids a set stores without allocating memory
+#define ROUTE_SET_INLINE 4
+
+/** A set of Route ids.
+ * The ids are kept in ascending order. Small sets store them inside the
+ * structure, larger ones in an array that grows as needed. A set filled
+ * with zeros is a valid, empty set.
+ */
+struct RouteSet {
+	/// number of ids in the set
+	unsigned count;
+	/// number of ids that fit in the array, 0 if the ids are stored inline
+	unsigned capacity;
+	union {
+		/// the ids, used when capacity is 0
+		unsigned ids[ROUTE_SET_INLINE];
+		/// the ids, used when capacity isn't 0
+		unsigned *array;
+	};
+};
+
+/// check if the set contains the id
+bool routeSetHas(const RouteSet *set, unsigned id);
+/// make sure that a number of ids can be added without allocating memory
+bool routeSetReserve(RouteSet *set, unsigned extra);
+/// debug function, check invariants of the set
+bool routeSetTest(const RouteSet *set);
+/// get the number of ids in the set
+unsigned routeSetCount(const RouteSet *set);
+/// get the id at a given position, ids are sorted in ascending order
+unsigned routeSetGet(const RouteSet *set, unsigned index);
+/// add an id to the set, space must have been reserved beforehand
+void routeSetAdd(RouteSet *set, unsigned id);
+/// remove all ids and release the memory used
+void routeSetClear(RouteSet *set);
+/// remove an id from the set
+void routeSetRemove(RouteSet *set, unsigned id);
+
+#endif //MAP_ROUTE_SET_H
@@ -0,0 +1,173 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "route_table.h"
+#include "trunk.h"
+
+#define INIT_SPACE 8
+#define EMPTY SIZE_MAX
+
+/** All Routes of a map.
+ * The Routes are stored densely, so that walking over them costs time
+ * proportional to their number. An open addressing hash table with linear
+ * probing maps ids to positions in the dense arrays.
+ */
+struct RouteTable {
+	/// the Routes, in no particular order
+	Trunk **trunks;
+	/// ids of the Routes, in the same order
+	unsigned *ids;
+	/// number of Routes in the table
+	size_t length;
+	/// number of records available in trunks and ids
+	size_t maxLength;
+	/// positions in the dense arrays, EMPTY if the slot is free
+	size_t *slots;
+	/// number of slots, a power of two at least twice maxLength
+	size_t slotCount;
+};
+
+//! @cond
+static bool rehash(RouteTable *table, size_t slotCount);
+static size_t findSlot(const RouteTable *table, unsigned id);
+static size_t hash(unsigned id, size_t slotCount);
+static void removeSlot(RouteTable *table, size_t slot);
+//! @endcond
+
+RouteTable *routeTableInit(void) {
+	RouteTable *ans = calloc(1, sizeof(RouteTable));
+	if (ans) {
+		ans->trunks = malloc(INIT_SPACE * sizeof(Trunk *));
+		ans->ids = malloc(INIT_SPACE * sizeof(unsigned));
+		if (ans->trunks && ans->ids && rehash(ans, 2 * INIT_SPACE)) {
+			ans->maxLength = INIT_SPACE;
+			return ans;
+		}
+		free(ans->trunks);
+		free(ans->ids);
+		free(ans);
+	}
+	return NULL;
+}
+
+void routeTableDestroy(RouteTable **pTable) {
+	RouteTable *table = *pTable;
+	free(table->trunks);
+	free(table->ids);
+	free(table->slots);
+	free(table);
+	*pTable = NULL;
+}
+
+size_t routeTableCount(const RouteTable *table) {
+	return table->length;
+}
+
+Trunk *routeTableGet(const RouteTable *table, size_t index) {
+	assert(index < table->length);
+	return table->trunks[index];
+}
+
+Trunk *routeTableFind(const RouteTable *table, unsigned id) {
+	size_t slot = findSlot(table, id);
+	if (table->slots[slot] == EMPTY)
+		return NULL;
+	return table->trunks[table->slots[slot]];
+}
+
+bool routeTableReserve(RouteTable *table) {
+	if (table->length < table->maxLength)
+		return true;
+	const size_t newMax = 2 * table->maxLength;
+	Trunk **trunks = realloc(table->trunks, newMax * sizeof(Trunk *));
+	if (trunks == NULL)
+		return false;
+	table->trunks = trunks;
+	unsigned *ids = realloc(table->ids, newMax * sizeof(unsigned));
+	if (ids == NULL)
+		return false;
+	table->ids = ids;
+	if (!rehash(table, 2 * newMax))
+		return false;
+	table->maxLength = newMax;
+	return true;
+}
+
+void routeTableInsert(RouteTable *table, Trunk *trunk) {
+	unsigned id = trunkGetId(trunk);
+	size_t slot = findSlot(table, id);
+	assert(table->length < table->maxLength);
+	assert(table->slots[slot] == EMPTY);
+	table->trunks[table->length] = trunk;
+	table->ids[table->length] = id;
+	table->slots[slot] = table->length;
+	++table->length;
+}
+
+Trunk *routeTableReplace(RouteTable *table, Trunk *trunk) {
+	size_t slot = findSlot(table, trunkGetId(trunk));
+	assert(table->slots[slot] != EMPTY);
+	Trunk **record = &table->trunks[table->slots[slot]];
+	Trunk *ans = *record;
+	*record = trunk;
+	return ans;
+}
+
+Trunk *routeTableRemove(RouteTable *table, unsigned id) {
+	size_t slot = findSlot(table, id);
+	if (table->slots[slot] == EMPTY)
+		return NULL;
+	const size_t position = table->slots[slot], last = table->length - 1;
+	Trunk *ans = table->trunks[position];
+	removeSlot(table, slot);
+	if (position != last) {
+		table->trunks[position] = table->trunks[last];
+		table->ids[position] = table->ids[last];
+		table->slots[findSlot(table, table->ids[position])] = position;
+	}
+	--table->length;
+	return ans;
+}
+
+//! @cond
+static size_t hash(unsigned id, size_t slotCount) {
+	return (size_t) (id * UINT64_C(0x9E3779B97F4A7C15) >> 32) & (slotCount - 1);
+}
+
+// the slot holding the id, or the empty slot where it would be inserted
+static size_t findSlot(const RouteTable *table, unsigned id) {
+	const size_t mask = table->slotCount - 1;
+	size_t slot = hash(id, table->slotCount);
+	while (table->slots[slot] != EMPTY && table->ids[table->slots[slot]] != id)
+		slot = (slot + 1) & mask;
+	return slot;
+}
+
+// backward shift deletion, keeps every probe sequence free of gaps
+static void removeSlot(RouteTable *table, size_t slot) {
+	const size_t mask = table->slotCount - 1;
+	size_t next = (slot + 1) & mask;
+	for (; table->slots[next] != EMPTY; next = (next + 1) & mask) {
+		size_t home = hash(table->ids[table->slots[next]], table->slotCount);
+		if (((next - home) & mask) >= ((next - slot) & mask)) {
+			table->slots[slot] = table->slots[next];
+			slot = next;
+		}
+	}
+	table->slots[slot] = EMPTY;
+}
+
+static bool rehash(RouteTable *table, size_t slotCount) {
+	size_t *slots = malloc(slotCount * sizeof(size_t));
+	if (slots == NULL)
+		return false;
+	free(table->slots);
+	table->slots = slots;
+	table->slotCount = slotCount;
+	for (size_t i = 0; i < slotCount; ++i)
+		slots[i] = EMPTY;
+	for (size_t i = 0; i < table->length; ++i)
+		slots[findSlot(table, table->ids[i])] = i;
+	return true;
+}
+//! @endcond
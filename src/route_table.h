@@ -0,0 +1,30 @@
+/** @file
+ * Interface for a registry of all Routes in a map, indexed by id.
+ */
+
+#ifndef MAP_ROUTE_TABLE_H
+#define MAP_ROUTE_TABLE_H
+
+#include <stdbool.h>
+#include "global_declarations.h"
+
+/// make sure that a Route can be inserted without allocating memory
+bool routeTableReserve(RouteTable *table);
+/// get the number of Routes in the table
+size_t routeTableCount(const RouteTable *table);
+/// destroy the table, the Routes are left intact
+void routeTableDestroy(RouteTable **pTable);
+/// insert a Route, space must have been reserved beforehand
+void routeTableInsert(RouteTable *table, Trunk *trunk);
+/// find a Route with a given id, NULL if there is none
+Trunk *routeTableFind(const RouteTable *table, unsigned id);
+/// get a Route at a given position, positions change when Routes are removed
+Trunk *routeTableGet(const RouteTable *table, size_t index);
+/// remove the Route with a given id from the table and return it
+Trunk *routeTableRemove(RouteTable *table, unsigned id);
+/// replace a Route with one with the same id, return the old one
+Trunk *routeTableReplace(RouteTable *table, Trunk *trunk);
+/// create an empty table
+RouteTable *routeTableInit(void);
+
+#endif //MAP_ROUTE_TABLE_H
@@ -0,0 +1,1054 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cache.h"
+#include "city.h"
+#include "city_map.h"
+#include "components.h"
+#include "exclusion.h"
+#include "landmark.h"
+#include "overlay.h"
+#include "pool.h"
+#include "queue.h"
+#include "road.h"
+#include "search.h"
+#include "stepping.h"
+
+#define AIM_SCALE 8
+#define CHECK_INTERVAL 256
+#define GROWTH 4
+#define INIT_SPACE 8
+
+/// The result of a search for a single city.
+typedef struct SearchRecord SearchRecord;
+
+/// One of the two searches meeting in the middle.
+typedef struct SearchSide SearchSide;
+
+/// Tasks given to the pool, with the workspace of the calling thread.
+typedef struct SearchBatch SearchBatch;
+
+/// Searches from many cities to the same targets, one per source.
+typedef struct SearchMatrix SearchMatrix;
+
+/** A workspace for path searches.
+ * A path is searched for from both ends at once, the searches meet in the
+ * middle. If landmarks are available, there is a single search instead,
+ * going towards the target first. If the map is split into cells, a search
+ * with nothing excluded goes over the overlay of the cells. The results are
+ * kept in a cache, so a search repeated before the map changes is free.
+ * A search for a city in another connected part of the map fails at once.
+ * A search expected to find a short path can be bounded, the bound grows
+ * until the path found can't be beaten by the paths it left out. A query
+ * can be run a number of cities at a time, with a deadline, so that other
+ * work can be done in between; such queries made through the map interface
+ * run in a workspace of their own, so the searches of other commands don't
+ * disturb them. A query in progress is given up when the map changes; the
+ * version of the workspace tells the query that happened.
+ * Independent searches can be run in parallel by a pool of threads, each
+ * with a workspace of its own; these only search from both ends.
+ *
+ * The records persist between searches. A record is valid only if it is
+ * stamped with the epoch of the search in progress, so a new search doesn't
+ * have to clear them and only pays for the cities it reaches.
+ */
+struct Search {
+	/// cities and roads the search may not use
+	Exclusion *exclusion;
+	/// results of recent searches
+	Cache *cache;
+	/// connected parts of the map, to give up at once on a city in another one
+	Components *components;
+	/// the search starting at the first city of the path
+	SearchSide *forward;
+	/// the search starting at the last city of the path
+	SearchSide *backward;
+	/// lower bounds on distances, NULL if there are none
+	Landmarks *landmarks;
+	/// cells of the map with shortcuts across them, NULL if there are none
+	Overlay *overlay;
+	/// threads running searches in parallel, NULL if there are none
+	Pool *pool;
+	/// workspaces of the threads of the pool
+	Search **helpers;
+	/// workspace of the queries run by steps through the map interface, NULL until there is one
+	Search *stepped;
+	/// the city the search aims at, NULL if the searches meet in the middle
+	City *target;
+	/// the first city of the path searched for by the query in progress
+	City *from;
+	/// the last city of the path searched for by the query in progress
+	City *to;
+	/// the map searched by the query in progress
+	const CityMap *cityMap;
+	/// the path found by the last query, until it is taken
+	Road **result;
+	/// length of that path, 0 if memory or time ran out, SIZE_MAX if there is none
+	size_t resultLength;
+	/// the time the query in progress fails at, if timed
+	struct timespec deadline;
+	/// number of records available on each side
+	size_t length;
+	/// length of the shortest path between the ends found so far
+	size_t best;
+	/// paths longer than this aren't followed, SIZE_MAX if there is no bound
+	size_t limit;
+	/// the epoch of the search in progress, never 0 after a reset
+	unsigned epoch;
+	/// length of the longest road a search may come across
+	unsigned longest;
+	/// width of the buckets of searches to all cities, 0 if these run one city at a time
+	unsigned delta;
+	/// number of changes of the map and of queries begun, a query is valid while it doesn't change
+	unsigned version;
+	/// true if the bound left out a path that could be the best one
+	bool cut;
+	/// true while the query isn't over
+	bool running;
+	/// true if the query has a deadline
+	bool timed;
+	/// true if the path found was chosen among others by years
+	bool tied;
+};
+
+//! @cond
+struct SearchRecord {
+	/// length of the shortest path found so far
+	size_t distance;
+	/// the last road of the best path found so far
+	Road *road;
+	/// the city the last road leads from, NULL for the end the search starts at
+	City *previous;
+	/// number of roads of the best path found so far
+	size_t hops;
+	/// the epoch of the search the record belongs to
+	unsigned stamp;
+	/// the highest minimum year among the shortest paths
+	int year;
+	/// the second highest minimum year, valid if there are two paths
+	int year2;
+	/// number of the shortest paths, counting stops at two
+	unsigned char paths;
+	/// true if the distance is final
+	bool settled;
+};
+
+struct SearchSide {
+	/// the priority queue, kept to avoid reallocating it
+	Heap *queue;
+	/// records of the cities, indexed by city id
+	SearchRecord *records;
+	/// settled cities, in the order they were settled
+	City **order;
+	/// number of settled cities
+	size_t settled;
+};
+
+struct SearchBatch {
+	/// the workspace of the calling thread
+	Search *search;
+	/// the task to run
+	SearchTask *task;
+	/// passed on to every task
+	void *context;
+};
+
+struct SearchMatrix {
+	/// the map searched
+	const CityMap *cityMap;
+	/// the cities the searches start from
+	City *const *sources;
+	/// the cities the distances are needed to
+	City *const *targets;
+	/// true for the targets, by city id
+	const bool *marks;
+	/// the results, a row for every source
+	CityDistance *distances;
+	/// true for the sources the search failed for
+	bool *failed;
+	/// number of targets
+	size_t targetCount;
+	/// number of different cities among the targets
+	size_t markCount;
+};
+
+static const SearchRecord blank = {.distance = 0, .road = NULL, .previous = NULL, .hops = 0, .paths = 0, .settled = false};
+
+static bool adjust(Search *search, size_t cityCount);
+static bool adjustSide(SearchSide *side, size_t length, size_t newLength);
+static bool isUnique(const SearchRecord *record);
+static bool advance(Search *search);
+static bool expired(const Search *search);
+static void reach(Search *search, City *from, City *to1, City *to2);
+static bool reset(Search *search, size_t cityCount, City *target);
+static size_t priority(const Search *search, size_t cityId, size_t distance);
+static void abandon(Search *search);
+static void addYear(SearchRecord *record, int year);
+static void change(Search *search);
+static void conclude(Search *search);
+static void dropWorkers(Search *search);
+static void explore(Search *search, City *from, const bool *marks, size_t markCount);
+static void measure(void *context, Search *search, size_t index);
+static CityDistance describe(const Search *search, size_t cityId);
+static void restart(Search *search);
+static void runTask(void *context, unsigned worker, size_t index);
+static void settle(Search *search, SearchSide *side, const SearchSide *other, City *city);
+static void sideDestroy(SearchSide **pSide);
+static void start(Search *search, SearchSide *side, const SearchSide *other, City *city);
+static void visit(Search *search, SearchSide *side, const SearchSide *other, City *current);
+static Road *join(const Search *search, City **pFrom, City **pTo, SearchRecord *joint);
+static Road **makeList(const Search *search, City *from, City *to, size_t *length, bool *tied);
+static SearchSide *sideInit(void);
+static const SearchRecord *peek(const Search *search, const SearchSide *side, size_t cityId);
+static SearchRecord *touch(Search *search, SearchSide *side, size_t cityId);
+//! @endcond
+
+Search *searchInit(void) {
+	Search *ans = malloc(sizeof(Search));
+	if (ans) {
+		*ans = (Search) {
+			.epoch = 0,
+			.longest = 0,
+			.delta = 0,
+			.version = 0,
+			.length = INIT_SPACE,
+			.best = SIZE_MAX,
+			.limit = SIZE_MAX,
+			.cut = false,
+			.running = false,
+			.timed = false,
+			.tied = false,
+			.result = NULL,
+			.resultLength = 0,
+			.landmarks = NULL,
+			.overlay = NULL,
+			.pool = NULL,
+			.helpers = NULL,
+			.stepped = NULL,
+			.target = NULL,
+			.forward = sideInit(),
+		};
+		if (ans->forward) {
+			ans->backward = sideInit();
+			if (ans->backward) {
+				ans->exclusion = exclusionInit();
+				if (ans->exclusion) {
+					ans->cache = cacheInit();
+					if (ans->cache) {
+						ans->components = componentsInit();
+						if (ans->components)
+							return ans;
+						cacheDestroy(&ans->cache);
+					}
+					exclusionDestroy(&ans->exclusion);
+				}
+				sideDestroy(&ans->backward);
+			}
+			sideDestroy(&ans->forward);
+		}
+		free(ans);
+	}
+	return NULL;
+}
+
+void searchDestroy(Search **pSearch) {
+	Search *search = *pSearch;
+	dropWorkers(search);
+	if (search->stepped)
+		searchDestroy(&search->stepped);
+	free(search->result);
+	exclusionDestroy(&search->exclusion);
+	cacheDestroy(&search->cache);
+	componentsDestroy(&search->components);
+	sideDestroy(&search->forward);
+	sideDestroy(&search->backward);
+	if (search->landmarks)
+		landmarksDestroy(&search->landmarks);
+	if (search->overlay)
+		overlayDestroy(&search->overlay);
+	free(search);
+	*pSearch = NULL;
+}
+
+Exclusion *searchExclusion(Search *search) {
+	return search->exclusion;
+}
+
+// landmarks or cells that can't be updated are dropped, searches don't need them
+void searchNoteRoad(Search *search, Road *road) {
+	if (roadGetLength(road) > search->longest)
+		search->longest = roadGetLength(road);
+	if (search->landmarks && !landmarksNoteRoad(search->landmarks, road))
+		landmarksDestroy(&search->landmarks);
+	if (search->overlay && !overlayNoteRoad(search->overlay, road))
+		overlayDestroy(&search->overlay);
+	componentsNoteRoad(search->components, road);
+	cacheNoteTopology(search->cache);
+	change(search);
+	for (unsigned i = 0; search->pool && i < poolThreadCount(search->pool); ++i)
+		searchNoteRoad(search->helpers[i], road);
+	if (search->stepped)
+		searchNoteRoad(search->stepped, road);
+}
+
+void searchNoteRemoval(Search *search, Road *road) {
+	if (search->overlay)
+		overlayNoteChange(search->overlay, road);
+	componentsNoteRemoval(search->components, road);
+	cacheNoteTopology(search->cache);
+	change(search);
+	for (unsigned i = 0; search->pool && i < poolThreadCount(search->pool); ++i)
+		searchNoteRemoval(search->helpers[i], road);
+	if (search->stepped)
+		searchNoteRemoval(search->stepped, road);
+}
+
+// a repair doesn't change the lengths, so it can only change the choice between shortest paths
+void searchNoteRepair(Search *search, Road *road) {
+	if (search->overlay)
+		overlayNoteChange(search->overlay, road);
+	cacheNoteYears(search->cache);
+	change(search);
+	for (unsigned i = 0; search->pool && i < poolThreadCount(search->pool); ++i)
+		searchNoteRepair(search->helpers[i], road);
+	if (search->stepped)
+		searchNoteRepair(search->stepped, road);
+}
+
+bool searchPrepareLandmarks(Search *search, CityMap *cityMap, unsigned count) {
+	if (search->landmarks)
+		landmarksDestroy(&search->landmarks);
+	if (count == 0 || cityMapGetLength(cityMap) == 0)
+		return true;
+	search->landmarks = landmarksInit(cityMap, count, search->longest);
+	return search->landmarks != NULL;
+}
+
+bool searchPrepareOverlay(Search *search, CityMap *cityMap, unsigned cellSize) {
+	if (search->overlay)
+		overlayDestroy(&search->overlay);
+	if (cellSize == 0)
+		return true;
+	search->overlay = overlayInit(cityMap, cellSize, search->longest);
+	return search->overlay != NULL;
+}
+
+// the cached results refer to excluded cities by their ids
+void searchRenumber(Search *search, CityMap *cityMap) {
+	componentsNoteChange(search->components);
+	cacheNoteTopology(search->cache);
+	change(search);
+	for (unsigned i = 0; search->pool && i < poolThreadCount(search->pool); ++i)
+		searchRenumber(search->helpers[i], cityMap);
+	if (search->stepped)
+		searchRenumber(search->stepped, cityMap);
+	if (search->landmarks)
+		searchPrepareLandmarks(search, cityMap, landmarksCount(search->landmarks));
+	if (search->overlay)
+		searchPrepareOverlay(search, cityMap, overlayCellSize(search->overlay));
+}
+
+// the workspaces of the threads start with no results and no landmarks
+bool searchPrepareWorkers(Search *search, unsigned threadCount) {
+	dropWorkers(search);
+	if (threadCount == 0)
+		return true;
+	search->helpers = calloc(threadCount, sizeof(Search *));
+	if (search->helpers) {
+		unsigned i = 0;
+		for (; i < threadCount; ++i) {
+			search->helpers[i] = searchInit();
+			if (search->helpers[i] == NULL)
+				break;
+			search->helpers[i]->longest = search->longest;
+		}
+		if (i == threadCount) {
+			search->pool = poolInit(threadCount);
+			if (search->pool)
+				return true;
+		}
+		while (i > 0)
+			searchDestroy(&search->helpers[--i]);
+		free(search->helpers);
+		search->helpers = NULL;
+	}
+	return false;
+}
+
+// the workspace is made at first use, it knows only the longest road of the map
+Search *searchStepped(Search *search) {
+	if (search->stepped == NULL) {
+		search->stepped = searchInit();
+		if (search->stepped)
+			search->stepped->longest = search->longest;
+	}
+	return search->stepped;
+}
+
+unsigned searchVersion(const Search *search) {
+	return search->version;
+}
+
+void searchUseStepping(Search *search, unsigned delta) {
+	search->delta = delta;
+}
+
+void searchEach(Search *search, size_t count, SearchTask *task, void *context) {
+	if (search->pool == NULL) {
+		for (size_t i = 0; i < count; ++i)
+			task(context, search, i);
+		return;
+	}
+	SearchBatch batch = {.search = search, .task = task, .context = context};
+	poolRun(search->pool, count, runTask, &batch);
+}
+
+/* out of memory errors set length to 0, lack of path to SIZE_MAX; detours
+ * and extensions exclude cities, the overlay doesn't take them into account
+ */
+Road **searchPath(Search *search, City *from, City *to, const CityMap *cityMap, size_t *length) {
+	return searchPathWithin(search, from, to, cityMap, SIZE_MAX, length);
+}
+
+Road **searchPathWithin(Search *search, City *from, City *to, const CityMap *cityMap, size_t radius,
+		size_t *length) {
+	searchBegin(search, from, to, cityMap, radius, NULL);
+	while (!searchStep(search, SIZE_MAX))
+		continue;
+	return searchResult(search, length);
+}
+
+/* a query answered by the index of connected parts, the cache or the
+ * overlay is over at once; the bound only leaves out paths longer than
+ * itself, so the results don't depend on it
+ */
+void searchBegin(Search *search, City *from, City *to, const CityMap *cityMap, size_t radius,
+		const struct timespec *deadline) {
+	assert(!search->running);
+	++search->version;
+	free(search->result);
+	search->from = from;
+	search->to = to;
+	search->cityMap = cityMap;
+	search->result = NULL;
+	search->resultLength = SIZE_MAX;
+	search->timed = (deadline != NULL);
+	if (deadline)
+		search->deadline = *deadline;
+	search->running = false;
+	search->tied = false;
+	if (!componentsConnected(search->components, cityMap, from, to))
+		return;
+	if (cacheFind(search->cache, from, to, search->exclusion, &search->result, &search->resultLength))
+		return;
+	if (search->overlay && exclusionEmpty(search->exclusion)) {
+		search->result = overlayPath(search->overlay, from, to, cityMap, &search->resultLength, &search->tied);
+		conclude(search);
+		return;
+	}
+	search->limit = (radius > 0 ? radius : 1);
+	search->running = true;
+	restart(search);
+}
+
+// the deadline is checked every few cities, so a step may run over it a little
+bool searchStep(Search *search, size_t budget) {
+	for (size_t i = 0; search->running && i < budget; ++i) {
+		if (search->timed && i % CHECK_INTERVAL == 0 && expired(search)) {
+			abandon(search);
+			break;
+		}
+		if (!advance(search))
+			conclude(search);
+	}
+	return !search->running;
+}
+
+void searchCancel(Search *search) {
+	if (search->running)
+		abandon(search);
+	free(search->result);
+	search->result = NULL;
+	search->resultLength = 0;
+}
+
+bool searchDone(const Search *search) {
+	return !search->running;
+}
+
+Road **searchResult(Search *search, size_t *length) {
+	assert(!search->running);
+	Road **ans = search->result;
+	*length = search->resultLength;
+	search->result = NULL;
+	search->resultLength = 0;
+	return ans;
+}
+
+/* out of memory errors set both lengths to 0, a path not found or not
+ * unique has length SIZE_MAX; so does a path longer than the other one if
+ * that is unique, as it would never be chosen
+ */
+void searchPathPair(Search *search, City *from, City *to1, City *to2, const CityMap *cityMap,
+		Road **paths[2], size_t lengths[2]) {
+	// a target in another part of the map is left out of the search
+	assert(!search->running);
+	City *const targets[2] = {
+		componentsConnected(search->components, cityMap, from, to1) ? to1 : NULL,
+		componentsConnected(search->components, cityMap, from, to2) ? to2 : NULL,
+	};
+	bool tied;
+	paths[0] = paths[1] = NULL;
+	lengths[0] = lengths[1] = SIZE_MAX;
+	if (targets[0] == NULL && targets[1] == NULL)
+		return;
+	lengths[0] = lengths[1] = 0;
+	if (!reset(search, cityMapGetLength(cityMap), NULL))
+		return;
+	reach(search, from, targets[0], targets[1]);
+	for (int i = 0; i < 2; ++i) {
+		lengths[i] = SIZE_MAX;
+		if (targets[i] == NULL || !peek(search, search->forward, cityGetId(targets[i]))->settled)
+			continue;
+		// the records are those of a single search, as if it aimed at the target
+		search->target = targets[i];
+		paths[i] = makeList(search, from, targets[i], &lengths[i], &tied);
+		if (lengths[i] == 0) {
+			free(paths[0]);
+			paths[0] = paths[1] = NULL;
+			lengths[0] = lengths[1] = 0;
+			return;
+		}
+	}
+}
+
+// the year of a city that can't be reached is 0
+bool searchDistances(Search *search, City *from, CityMap *cityMap, CityDistance *distances) {
+	assert(!search->running);
+	// with roads much longer than the buckets the sequential search is used
+	if (search->delta > 0 && exclusionEmpty(search->exclusion) && steppingFits(search->delta, search->longest))
+		return steppingDistances(search->pool, cityMap, from, search->delta, search->longest, distances);
+	const size_t cityCount = cityMapGetLength(cityMap);
+	if (!reset(search, cityCount, NULL))
+		return false;
+	explore(search, from, NULL, 0);
+	for (size_t i = 0; i < cityCount; ++i)
+		distances[i] = describe(search, i);
+	return true;
+}
+
+// the searches from different sources are independent, so they are run on all threads
+bool searchMatrix(Search *search, City *const *sources, size_t sourceCount, City *const *targets,
+		size_t targetCount, const CityMap *cityMap, CityDistance *distances) {
+	const size_t cityCount = cityMapGetLength(cityMap);
+	bool ans = false;
+	bool *marks = calloc(cityCount > 0 ? cityCount : 1, sizeof(bool));
+	bool *failed = calloc(sourceCount > 0 ? sourceCount : 1, sizeof(bool));
+	if (marks && failed) {
+		SearchMatrix matrix = {
+			.cityMap = cityMap,
+			.sources = sources,
+			.targets = targets,
+			.marks = marks,
+			.distances = distances,
+			.failed = failed,
+			.targetCount = targetCount,
+			.markCount = 0,
+		};
+		for (size_t i = 0; i < targetCount; ++i) {
+			if (!marks[cityGetId(targets[i])]) {
+				marks[cityGetId(targets[i])] = true;
+				++matrix.markCount;
+			}
+		}
+		searchEach(search, sourceCount, measure, &matrix);
+		ans = true;
+		for (size_t i = 0; i < sourceCount; ++i)
+			ans = ans && !failed[i];
+	}
+	free(marks);
+	free(failed);
+	return ans;
+}
+
+void searchStatistics(const Search *search, size_t *hits, size_t *misses) {
+	cacheStatistics(search->cache, hits, misses);
+}
+
+static void dropWorkers(Search *search) {
+	if (search->pool == NULL)
+		return;
+	const unsigned threadCount = poolThreadCount(search->pool);
+	poolDestroy(&search->pool);
+	for (unsigned i = 0; i < threadCount; ++i)
+		searchDestroy(&search->helpers[i]);
+	free(search->helpers);
+	search->helpers = NULL;
+}
+
+static CityDistance describe(const Search *search, size_t cityId) {
+	const SearchRecord *record = peek(search, search->forward, cityId);
+	return (CityDistance) {
+		.distance = (record->settled ? record->distance : SIZE_MAX),
+		.year = (record->settled ? record->year : 0),
+		.unique = record->settled && isUnique(record),
+	};
+}
+
+// fills the row of a single source
+static void measure(void *context, Search *search, size_t index) {
+	SearchMatrix *matrix = context;
+	const size_t cityCount = cityMapGetLength(matrix->cityMap);
+	if (!exclusionReset(search->exclusion, cityCount) || !reset(search, cityCount, NULL)) {
+		matrix->failed[index] = true;
+		return;
+	}
+	explore(search, matrix->sources[index], matrix->marks, matrix->markCount);
+	CityDistance *row = matrix->distances + index * matrix->targetCount;
+	for (size_t i = 0; i < matrix->targetCount; ++i)
+		row[i] = describe(search, cityGetId(matrix->targets[i]));
+}
+
+static void runTask(void *context, unsigned worker, size_t index) {
+	SearchBatch *batch = context;
+	Search *search = (worker > 0 ? batch->search->helpers[worker - 1] : batch->search);
+	batch->task(batch->context, search, index);
+}
+
+static SearchSide *sideInit(void) {
+	SearchSide *ans = malloc(sizeof(SearchSide));
+	if (ans) {
+		*ans = (SearchSide) {
+			.settled = 0,
+			.records = calloc(INIT_SPACE, sizeof(SearchRecord)),
+			.order = malloc(INIT_SPACE * sizeof(City *)),
+		};
+		if (ans->records && ans->order) {
+			ans->queue = queueInit();
+			if (ans->queue)
+				return ans;
+		}
+		free(ans->records);
+		free(ans->order);
+		free(ans);
+	}
+	return NULL;
+}
+
+static void sideDestroy(SearchSide **pSide) {
+	SearchSide *side = *pSide;
+	queueDestroy(&side->queue);
+	free(side->records);
+	free(side->order);
+	free(side);
+	*pSide = NULL;
+}
+
+static bool adjustSide(SearchSide *side, size_t length, size_t newLength) {
+	SearchRecord *records = realloc(side->records, newLength * sizeof(SearchRecord));
+	if (records == NULL)
+		return false;
+	memset(records + length, 0, (newLength - length) * sizeof(SearchRecord));
+	side->records = records;
+	City **order = realloc(side->order, newLength * sizeof(City *));
+	if (order == NULL)
+		return false;
+	side->order = order;
+	return true;
+}
+
+// the records that were added are zeroed, so they don't have a valid stamp
+static bool adjust(Search *search, size_t cityCount) {
+	if (cityCount <= search->length)
+		return true;
+	size_t newLength = search->length;
+	while (newLength < cityCount)
+		newLength *= 2;
+	if (!adjustSide(search->forward, search->length, newLength))
+		return false;
+	if (!adjustSide(search->backward, search->length, newLength))
+		return false;
+	search->length = newLength;
+	return true;
+}
+
+// start a new search, the queues are emptied and all records become invalid
+static bool reset(Search *search, size_t cityCount, City *target) {
+	if (!adjust(search, cityCount))
+		return false;
+	if (search->epoch == (unsigned) -1) {
+		for (size_t i = 0; i < search->length; ++i) {
+			search->forward->records[i].stamp = 0;
+			search->backward->records[i].stamp = 0;
+		}
+		search->epoch = 0;
+	}
+	++search->epoch;
+	search->best = SIZE_MAX;
+	search->target = target;
+	search->forward->settled = 0;
+	search->backward->settled = 0;
+	if (target) {
+		// a road raises the priority by less than its length times this
+		const uint64_t step = (uint64_t) search->longest * (2 * AIM_SCALE - 1);
+		return queuePrepare(search->forward->queue, cityCount, step < UINT32_MAX ? (unsigned) step : UINT32_MAX);
+	}
+	if (!queuePrepare(search->forward->queue, cityCount, search->longest))
+		return false;
+	return queuePrepare(search->backward->queue, cityCount, search->longest);
+}
+
+static const SearchRecord *peek(const Search *search, const SearchSide *side, size_t cityId) {
+	assert(cityId < search->length);
+	const SearchRecord *ans = &side->records[cityId];
+	return (ans->stamp == search->epoch ? ans : &blank);
+}
+
+static SearchRecord *touch(Search *search, SearchSide *side, size_t cityId) {
+	assert(cityId < search->length);
+	SearchRecord *ans = &side->records[cityId];
+	if (ans->stamp != search->epoch) {
+		*ans = blank;
+		ans->stamp = search->epoch;
+	}
+	return ans;
+}
+
+/* the path is made of the best path to the first end of the joining road,
+ * the road and the best path from its second end; a search aiming at the
+ * target has no joining road and a single part; the records know the number
+ * of roads of their paths, so each part is written in a single pass
+ */
+static Road **makeList(const Search *search, City *from, City *to, size_t *length, bool *tied) {
+	City *city1 = to, *city2 = to;
+	SearchRecord joint = *peek(search, search->forward, cityGetId(to));
+	Road *road = NULL;
+	if (search->target == NULL) {
+		joint = blank;
+		road = join(search, &city1, &city2, &joint);
+		assert(road);
+	}
+	*tied = joint.paths > 1;
+	if (!isUnique(&joint)) {
+		*length = SIZE_MAX;
+		return NULL;
+	}
+	const size_t length1 = peek(search, search->forward, cityGetId(city1))->hops;
+	const size_t length2 = (road ? peek(search, search->backward, cityGetId(city2))->hops : 0);
+	*length = length1 + (road ? 1 : 0) + length2;
+	Road **buffer = malloc(*length * sizeof(Road *));
+	if (buffer) {
+		if (road)
+			buffer[length1] = road;
+		for (size_t i = length1; i > 0; --i) {
+			const SearchRecord *record = peek(search, search->forward, cityGetId(city1));
+			buffer[i - 1] = record->road;
+			city1 = record->previous;
+		}
+		for (size_t i = length1 + 1; i < *length; ++i) {
+			const SearchRecord *record = peek(search, search->backward, cityGetId(city2));
+			buffer[i] = record->road;
+			city2 = record->previous;
+		}
+		assert(city1 == from && (road == NULL || city2 == to));
+		(void) from;
+		return buffer;
+	}
+	*length = 0;
+	return NULL;
+}
+
+/* every shortest path has exactly one road leading from a city closer to
+ * the first end than the limit to a city that isn't, the limit being the
+ * distance left in the forward queue or the length of the path if it is
+ * shorter; the first city of that road is settled by the forward search,
+ * the second one by the backward search, so going through all such roads
+ * finds the years of all shortest paths; returns the road of the best one
+ * and sets the cities to its ends
+ */
+static Road *join(const Search *search, City **pFrom, City **pTo, SearchRecord *joint) {
+	const SearchSide *forward = search->forward, *backward = search->backward;
+	size_t limit = search->best;
+	if (!queueEmpty(forward->queue) && queueTop(forward->queue) < limit)
+		limit = queueTop(forward->queue);
+	Road *ans = NULL;
+	for (size_t i = forward->settled; i > 0; --i) {
+		City *current = forward->order[i - 1];
+		const SearchRecord *position = peek(search, forward, cityGetId(current));
+		if (position->distance >= limit)
+			continue;
+		if (position->distance + search->longest < limit)
+			break;
+		const size_t roadCount = cityGetRoadCount(current);
+		for (size_t j = 0; j < roadCount; ++j) {
+			Road *r = cityGetRoad(current, j);
+			size_t nextId = cityGetId(cityNeighbour(current, j));
+			const size_t distance = position->distance + roadGetLength(r);
+			if (distance < limit || exclusionHasCity(search->exclusion, nextId)
+					|| exclusionHasRoad(search->exclusion, r))
+				continue;
+			const SearchRecord *rest = peek(search, backward, nextId);
+			if (!rest->settled || distance + rest->distance != search->best)
+				continue;
+			const int roadYear = roadGetYear(r);
+			const int year = (position->year < roadYear ? position->year : roadYear);
+			const int year2 = (position->year2 < roadYear ? position->year2 : roadYear);
+			const int top = (year < rest->year ? year : rest->year);
+			if (ans == NULL || top > joint->year) {
+				ans = r;
+				*pFrom = current;
+				*pTo = cityNeighbour(current, j);
+			}
+			addYear(joint, top);
+			if (position->paths > 1)
+				addYear(joint, year2 < rest->year ? year2 : rest->year);
+			if (rest->paths > 1)
+				addYear(joint, year < rest->year2 ? year : rest->year2);
+		}
+	}
+	return ans;
+}
+
+/* relaxes the roads leading out of a settled city, a city reached again with
+ * the same distance gets the minimum years of the new paths as well; a city
+ * reached by the other side gives a path between the ends
+ */
+static void visit(Search *search, SearchSide *side, const SearchSide *other, City *current) {
+	const SearchRecord position = *peek(search, side, cityGetId(current));
+	assert(!exclusionHasCity(search->exclusion, cityGetId(current)));
+	assert(position.settled);
+	const size_t roadCount = cityGetRoadCount(current);
+	for (size_t i = 0; i < roadCount; ++i) {
+		Road *r = cityGetRoad(current, i);
+		City *nextCity = cityNeighbour(current, i);
+		size_t nextId = cityGetId(nextCity);
+		if (exclusionHasCity(search->exclusion, nextId) || exclusionHasRoad(search->exclusion, r))
+			continue;
+		const int roadYear = roadGetYear(r);
+		const size_t distance = position.distance + roadGetLength(r);
+		const SearchRecord *rest = (other ? peek(search, other, nextId) : &blank);
+		if (rest->paths > 0 && distance + rest->distance < search->best)
+			search->best = distance + rest->distance;
+		if (distance > search->limit) {
+			search->cut = true;
+			continue;
+		}
+		SearchRecord *record = touch(search, side, nextId);
+		if (record->settled)
+			continue;
+		if (record->paths > 0 && distance > record->distance)
+			continue;
+		if (record->paths == 0 || distance < record->distance) {
+			*record = blank;
+			record->stamp = search->epoch;
+			record->distance = distance;
+		}
+		const int oldYear = record->year;
+		addYear(record, position.year < roadYear ? position.year : roadYear);
+		if (position.paths > 1)
+			addYear(record, position.year2 < roadYear ? position.year2 : roadYear);
+		if (record->road == NULL || record->year != oldYear) {
+			record->road = r;
+			record->previous = current;
+			record->hops = position.hops + 1;
+			queueUpdate(side->queue, nextCity, nextId, priority(search, nextId, distance), record->year);
+		}
+	}
+}
+
+// adds the minimum year of one more shortest path, keeps the two highest
+static void addYear(SearchRecord *record, int year) {
+	if (record->paths == 0) {
+		record->year = year;
+		record->paths = 1;
+	} else if (year > record->year) {
+		record->year2 = record->year;
+		record->year = year;
+		record->paths = 2;
+	} else if (record->paths == 1 || year > record->year2) {
+		record->year2 = year;
+		record->paths = 2;
+	}
+}
+
+// the best path is unique if no other shortest path has the same minimum year
+static bool isUnique(const SearchRecord *record) {
+	return record->paths < 2 || record->year2 < record->year;
+}
+
+/* a search aiming at the target takes cities in the order of the distance
+ * plus most of the bound on the distance left; the part of the bound left
+ * out makes every road raise the priority, so a city isn't taken before the
+ * cities on its shortest paths
+ */
+static size_t priority(const Search *search, size_t cityId, size_t distance) {
+	if (search->target == NULL)
+		return distance;
+	const size_t bound = landmarksBound(search->landmarks, cityId, cityGetId(search->target));
+	return AIM_SCALE * distance + (AIM_SCALE - 1) * bound;
+}
+
+static void settle(Search *search, SearchSide *side, const SearchSide *other, City *city) {
+	assert(side->settled < search->length);
+	touch(search, side, cityGetId(city))->settled = true;
+	side->order[side->settled++] = city;
+	visit(search, side, other, city);
+}
+
+static void start(Search *search, SearchSide *side, const SearchSide *other, City *city) {
+	SearchRecord *record = touch(search, side, cityGetId(city));
+	record->year = INT16_MAX;
+	record->paths = 1;
+	settle(search, side, other, city);
+}
+
+/* settles a single city of the query in progress, returns false once there
+ * is nothing left to search; a search aiming at the target is over when it
+ * takes the target, the searches from both ends always advance the one
+ * that is closer to its end until no path through the cities left in the
+ * queues can be shorter than the best one found
+ */
+static bool advance(Search *search) {
+	SearchSide *forward = search->forward, *backward = search->backward;
+	SearchSide *side = forward;
+	if (search->target) {
+		if (queueEmpty(forward->queue))
+			return false;
+	} else {
+		// a queue emptied by the bound would still hold cities beyond it
+		if (!search->cut && (queueEmpty(forward->queue) || queueEmpty(backward->queue)))
+			return false;
+		const size_t top1 = (queueEmpty(forward->queue) ? search->limit + 1 : queueTop(forward->queue));
+		const size_t top2 = (queueEmpty(backward->queue) ? search->limit + 1 : queueTop(backward->queue));
+		if (search->best != SIZE_MAX && top1 + top2 > search->best)
+			return false;
+		side = (top1 <= top2 ? forward : backward);
+		if (queueEmpty(side->queue))
+			return false;
+	}
+	size_t key;
+	int minYear;
+	City *current = queuePop(side->queue, &key, &minYear);
+	const SearchRecord *record = peek(search, side, cityGetId(current));
+	assert(priority(search, cityGetId(current), record->distance) == key && record->year == minYear);
+	(void) record;
+	(void) key;
+	(void) minYear;
+	if (current == search->target)
+		return false;
+	settle(search, side, search->target ? NULL : (side == forward ? backward : forward), current);
+	return true;
+}
+
+// starts the search of the query in progress over, with its current bound
+static void restart(Search *search) {
+	search->cut = false;
+	if (!reset(search, cityMapGetLength(search->cityMap), search->landmarks ? search->to : NULL)) {
+		abandon(search);
+		return;
+	}
+	if (search->target) {
+		queueStart(search->forward->queue, priority(search, cityGetId(search->from), 0));
+		start(search, search->forward, NULL, search->from);
+		return;
+	}
+	assert(search->from != search->to);
+	start(search, search->forward, search->backward, search->from);
+	start(search, search->backward, search->forward, search->to);
+}
+
+/* finishes the query once its search is over, or starts the search over
+ * with a wider bound if the bound could have left out the best path; a path
+ * within the bound is the best one, the cities on its shortest paths are all
+ * within the bound
+ */
+static void conclude(Search *search) {
+	if (search->running) {
+		const bool found = (search->target ? peek(search, search->forward, cityGetId(search->to))->paths > 0
+				: search->best != SIZE_MAX);
+		if (search->cut && (search->target ? !found : search->best > search->limit)) {
+			search->limit = (search->limit < SIZE_MAX / GROWTH ? search->limit * GROWTH : SIZE_MAX);
+			restart(search);
+			return;
+		}
+		search->running = false;
+		if (found)
+			search->result = makeList(search, search->from, search->to, &search->resultLength, &search->tied);
+	}
+	search->limit = SIZE_MAX;
+	if (search->resultLength > 0) {
+		cacheStore(search->cache, search->from, search->to, search->exclusion, search->result,
+				search->resultLength, search->tied);
+	}
+}
+
+// a query in progress can't go on with the map changed
+static void change(Search *search) {
+	if (search->running)
+		abandon(search);
+	++search->version;
+}
+
+// ends the query with no result, the bound mustn't stay for other searches
+static void abandon(Search *search) {
+	search->running = false;
+	search->resultLength = 0;
+	search->cut = false;
+	search->limit = SIZE_MAX;
+}
+
+static bool expired(const Search *search) {
+	struct timespec now;
+	timespec_get(&now, TIME_UTC);
+	if (now.tv_sec != search->deadline.tv_sec)
+		return now.tv_sec > search->deadline.tv_sec;
+	return now.tv_nsec >= search->deadline.tv_nsec;
+}
+/* settles cities in the order of their distance from the first one until
+ * all marked cities are settled, or all cities if none are marked
+ */
+static void explore(Search *search, City *from, const bool *marks, size_t markCount) {
+	SearchSide *forward = search->forward;
+	size_t found = (marks && marks[cityGetId(from)] ? 1 : 0);
+	start(search, forward, NULL, from);
+	while (!queueEmpty(forward->queue) && (marks == NULL || found < markCount)) {
+		size_t distance;
+		int minYear;
+		City *current = queuePop(forward->queue, &distance, &minYear);
+		if (marks && marks[cityGetId(current)])
+			++found;
+		settle(search, forward, NULL, current);
+	}
+}
+
+/* runs a single search from a city until it takes both targets, or the
+ * closer one has a unique best path and the other one is farther away; the
+ * targets are dead ends, so a path to one of them doesn't go through the other;
+ * a target that is NULL is left out
+ */
+static void reach(Search *search, City *from, City *to1, City *to2) {
+	SearchSide *forward = search->forward;
+	size_t limit = SIZE_MAX;
+	const unsigned wanted = (to1 != NULL) + (to2 != NULL);
+	unsigned found = 0;
+	start(search, forward, NULL, from);
+	while (found < wanted && !queueEmpty(forward->queue) && queueTop(forward->queue) <= limit) {
+		size_t distance;
+		int minYear;
+		City *current = queuePop(forward->queue, &distance, &minYear);
+		if (current != to1 && current != to2) {
+			settle(search, forward, NULL, current);
+			continue;
+		}
+		SearchRecord *record = touch(search, forward, cityGetId(current));
+		record->settled = true;
+		++found;
+		if (isUnique(record) && distance < limit)
+			limit = distance;
+	}
+}
+
+//! @endcond
@@ -0,0 +1,70 @@
+/** @file
+ * Interface for path searches in the road map, run in a reusable workspace.
+ */
+
+#ifndef MAP_SEARCH_H
+#define MAP_SEARCH_H
+
+#include <stdbool.h>
+#include <time.h>
+#include "global_declarations.h"
+
+/// A task run with a workspace of its own, for indices from 0 up.
+typedef void SearchTask(void *context, Search *search, size_t index);
+
+/// destroy the workspace
+void searchDestroy(Search **pSearch);
+/// find the best paths from a city to all others, filling the records by city id
+bool searchDistances(Search *search, City *from, CityMap *cityMap, CityDistance *distances);
+/// find the best paths from every source to every target, a row of records for every source
+bool searchMatrix(Search *search, City *const *sources, size_t sourceCount, City *const *targets,
+		size_t targetCount, const CityMap *cityMap, CityDistance *distances);
+/// run independent tasks, each with a workspace to itself, on all threads
+void searchEach(Search *search, size_t count, SearchTask *task, void *context);
+/// get the cities and roads excluded from the next search
+Exclusion *searchExclusion(Search *search);
+/// take into account a road added to the map, searches depend on the longest
+void searchNoteRoad(Search *search, Road *road);
+/// take into account a road about to be removed
+void searchNoteRemoval(Search *search, Road *road);
+/// take into account a repaired road
+void searchNoteRepair(Search *search, Road *road);
+/// find the best path between two cities
+Road **searchPath(Search *search, City *from, City *to, const CityMap *cityMap, size_t *length);
+/// start a query for the best path between two cities, to be run by steps, failing after the deadline if it isn't NULL
+void searchBegin(Search *search, City *from, City *to, const CityMap *cityMap, size_t radius,
+		const struct timespec *deadline);
+/// give up the query in progress and drop the result of the last one
+void searchCancel(Search *search);
+/// check if the query is over
+bool searchDone(const Search *search);
+/// take the path found by the query that is over, its length is 0 if memory or time ran out
+Road **searchResult(Search *search, size_t *length);
+/// run the query for up to a number of cities, return true if it is over
+bool searchStep(Search *search, size_t budget);
+/// find the best path between two cities, searching within a radius first and widening it until it is found
+Road **searchPathWithin(Search *search, City *from, City *to, const CityMap *cityMap, size_t radius,
+		size_t *length);
+/// find the best paths from a city to two others in a single search, leaving out the one that loses
+void searchPathPair(Search *search, City *from, City *to1, City *to2, const CityMap *cityMap,
+		Road **paths[2], size_t lengths[2]);
+/// choose landmarks to direct the searches towards their targets, 0 drops them
+bool searchPrepareLandmarks(Search *search, CityMap *cityMap, unsigned count);
+/// split the map into cells to speed up searches with nothing excluded, 0 stops it
+bool searchPrepareOverlay(Search *search, CityMap *cityMap, unsigned cellSize);
+/// start threads running searches in parallel, 0 stops them
+bool searchPrepareWorkers(Search *search, unsigned threadCount);
+/// take into account new ids of the cities, or the last cities removed
+void searchRenumber(Search *search, CityMap *cityMap);
+/// get the number of searches answered from the cache and run in full
+void searchStatistics(const Search *search, size_t *hits, size_t *misses);
+/// get the workspace for queries run by steps, taking changes of the map into account with this one
+Search *searchStepped(Search *search);
+/// get the version of the workspace, changed by the map and by every query begun
+unsigned searchVersion(const Search *search);
+/// search from a city to all others by delta-stepping with buckets of a width, 0 goes back to one city at a time
+void searchUseStepping(Search *search, unsigned delta);
+/// create a workspace for path searches
+Search *searchInit(void);
+
+#endif //MAP_SEARCH_H
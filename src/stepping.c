@@ -0,0 +1,418 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "city.h"
+#include "city_map.h"
+#include "pool.h"
+#include "road.h"
+#include "stepping.h"
+
+#define BUCKET_LIMIT ((size_t) 1 << 16)
+#define CHUNK 1024
+#define DELTA_LIMIT ((unsigned) 1 << 16)
+#define INIT_SPACE 8
+#define UNREACHABLE SIZE_MAX
+
+/// A growing array of city ids.
+typedef struct IdList IdList;
+
+//! @cond
+struct IdList {
+	size_t *ids;
+	size_t length;
+	size_t capacity;
+};
+
+//! @endcond
+
+/// The state of a single search from one city to all others.
+typedef struct Stepper Stepper;
+
+/** The best paths from one city to all others, found in two passes.
+ * The first pass finds the distances by delta-stepping. A bucket holds the
+ * cities with distances in a range of width delta; the cities of the lowest
+ * bucket that isn't empty are taken all at once and split between the
+ * threads. A road no longer than delta can lead to a city in the same
+ * bucket, so these roads are followed over and over until the bucket stays
+ * empty; longer roads lead to later buckets and are followed once for every
+ * city. A distance is lowered by an atomic compare and swap, each thread
+ * keeps buckets of its own for the cities it has reached.
+ *
+ * The second pass finds the years. The shortest paths to a city come from
+ * its neighbours that are closer by exactly the length of the road between
+ * them, so cities at the same distance don't depend on each other. These
+ * are taken in the order of distance and a city gets the two highest
+ * minimum years from its neighbours, the same as a sequential search would
+ * give it, as these don't depend on the order of the paths.
+ */
+struct Stepper {
+	/// the threads the work is split between, NULL if there are none
+	Pool *pool;
+	/// the cities, by id
+	City *const *cities;
+	/// tentative distances, by city id
+	_Atomic size_t *distances;
+	/// the round a city was last taken in, by city id
+	_Atomic unsigned *rounds;
+	/// true for the cities of the current bucket taken already, by city id
+	_Atomic bool *taken;
+	/// the highest minimum year among the shortest paths, by city id
+	int *years;
+	/// the second highest minimum year, by city id
+	int *years2;
+	/// number of the shortest paths, counting stops at two, by city id
+	unsigned char *paths;
+	/// buckets of every worker, bucketCount of them in a row
+	IdList *buckets;
+	/// the cities taken in the current bucket, by worker
+	IdList *settled;
+	/// the cities being worked on
+	IdList frontier;
+	/// all reached cities, in the order of their buckets
+	IdList order;
+	/// the number of cities in every distance of a bucket
+	size_t *counts;
+	/// number of cities
+	size_t cityCount;
+	/// the bucket being emptied
+	size_t current;
+	/// width of a bucket
+	unsigned delta;
+	/// number of buckets of a worker, enough for the longest road
+	size_t bucketCount;
+	/// number of workers, counting the calling thread
+	unsigned workerCount;
+	/// the number of the current round
+	unsigned round;
+	/// true if a worker ran out of memory
+	_Atomic bool failed;
+};
+
+//! @cond
+static bool append(IdList *list, const size_t *ids, size_t length);
+static bool bucketsEmpty(const Stepper *stepper, size_t bucket);
+static bool gather(Stepper *stepper, IdList *lists, size_t stride);
+static bool init(Stepper *stepper, Pool *pool, CityMap *cityMap, unsigned delta, unsigned longest);
+static bool relax(Stepper *stepper, unsigned worker, size_t cityId, bool light);
+static bool sortBucket(Stepper *stepper, size_t start);
+static size_t bucketCount(unsigned delta, unsigned longest);
+static unsigned width(unsigned delta);
+static void addYear(Stepper *stepper, size_t cityId, int year);
+static void destroy(Stepper *stepper);
+static void finish(void *context, unsigned worker, size_t index);
+static void relaxHeavy(void *context, unsigned worker, size_t index);
+static void relaxLight(void *context, unsigned worker, size_t index);
+static void run(Stepper *stepper, size_t count, PoolTask *task);
+static void year(Stepper *stepper, size_t cityId);
+//! @endcond
+
+bool steppingFits(unsigned delta, unsigned longest) {
+	return bucketCount(width(delta), longest) <= BUCKET_LIMIT;
+}
+
+// the largest distance of a city is SIZE_MAX - 1
+bool steppingDistances(Pool *pool, CityMap *cityMap, City *from, unsigned delta, unsigned longest,
+		CityDistance *distances) {
+	Stepper stepper;
+	bool ans = false;
+	if (!steppingFits(delta, longest))
+		return false;
+	if (init(&stepper, pool, cityMap, width(delta), longest)) {
+		const size_t fromId = cityGetId(from);
+		atomic_store(&stepper.distances[fromId], 0);
+		stepper.years[fromId] = INT16_MAX;
+		stepper.paths[fromId] = 1;
+		ans = append(&stepper.buckets[0], &fromId, 1);
+		for (size_t empty = 0; ans && empty < stepper.bucketCount; ++stepper.current) {
+			if (bucketsEmpty(&stepper, stepper.current)) {
+				++empty;
+				continue;
+			}
+			empty = 0;
+			// a city reached again in the same bucket is taken in another round
+			while (ans && !bucketsEmpty(&stepper, stepper.current)) {
+				ans = gather(&stepper, stepper.buckets + stepper.current % stepper.bucketCount, stepper.bucketCount);
+				++stepper.round;
+				if (ans)
+					run(&stepper, (stepper.frontier.length + CHUNK - 1) / CHUNK, relaxLight);
+				ans = ans && !atomic_load(&stepper.failed);
+			}
+			const size_t start = stepper.order.length;
+			ans = ans && gather(&stepper, stepper.settled, 1) && append(&stepper.order, stepper.frontier.ids, stepper.frontier.length);
+			if (ans)
+				run(&stepper, (stepper.frontier.length + CHUNK - 1) / CHUNK, relaxHeavy);
+			ans = ans && !atomic_load(&stepper.failed) && sortBucket(&stepper, start);
+		}
+		if (ans) {
+			for (size_t i = 0; i < stepper.cityCount; ++i) {
+				const size_t distance = atomic_load(&stepper.distances[i]);
+				const bool reached = (distance != UNREACHABLE);
+				distances[i] = (CityDistance) {
+					.distance = distance,
+					.year = (reached ? stepper.years[i] : 0),
+					.unique = reached && (stepper.paths[i] < 2 || stepper.years2[i] < stepper.years[i]),
+				};
+			}
+		}
+	}
+	destroy(&stepper);
+	return ans;
+}
+
+//! @cond
+static bool init(Stepper *stepper, Pool *pool, CityMap *cityMap, unsigned delta, unsigned longest) {
+	const size_t cityCount = cityMapGetLength(cityMap);
+	const size_t length = (cityCount > 0 ? cityCount : 1);
+	*stepper = (Stepper) {
+		.pool = pool,
+		.cities = cityMapSuffix(cityMap, 0),
+		.cityCount = cityCount,
+		.current = 0,
+		.delta = delta,
+		.bucketCount = bucketCount(delta, longest),
+		.workerCount = (pool ? poolThreadCount(pool) : 0) + 1,
+		.round = 0,
+		.frontier = {.ids = NULL, .length = 0, .capacity = 0},
+		.order = {.ids = NULL, .length = 0, .capacity = 0},
+		.distances = malloc(length * sizeof(_Atomic size_t)),
+		.rounds = malloc(length * sizeof(_Atomic unsigned)),
+		.taken = malloc(length * sizeof(_Atomic bool)),
+		.years = calloc(length, sizeof(int)),
+		.years2 = calloc(length, sizeof(int)),
+		.paths = calloc(length, sizeof(unsigned char)),
+		.counts = malloc(((size_t) delta + 1) * sizeof(size_t)),
+	};
+	atomic_init(&stepper->failed, false);
+	stepper->buckets = calloc((size_t) stepper->workerCount * stepper->bucketCount, sizeof(IdList));
+	stepper->settled = calloc(stepper->workerCount, sizeof(IdList));
+	if (!stepper->distances || !stepper->rounds || !stepper->taken || !stepper->years || !stepper->years2
+			|| !stepper->paths || !stepper->counts || !stepper->buckets || !stepper->settled)
+		return false;
+	for (size_t i = 0; i < cityCount; ++i) {
+		atomic_init(&stepper->distances[i], UNREACHABLE);
+		atomic_init(&stepper->rounds[i], (unsigned) -1);
+		atomic_init(&stepper->taken[i], false);
+	}
+	return true;
+}
+
+// works with a stepper that wasn't fully initialized as well
+static void destroy(Stepper *stepper) {
+	if (stepper->buckets) {
+		for (size_t i = 0; i < (size_t) stepper->workerCount * stepper->bucketCount; ++i)
+			free(stepper->buckets[i].ids);
+	}
+	if (stepper->settled) {
+		for (unsigned i = 0; i < stepper->workerCount; ++i)
+			free(stepper->settled[i].ids);
+	}
+	free(stepper->buckets);
+	free(stepper->settled);
+	free(stepper->frontier.ids);
+	free(stepper->order.ids);
+	free((void *) stepper->distances);
+	free((void *) stepper->rounds);
+	free((void *) stepper->taken);
+	free(stepper->years);
+	free(stepper->years2);
+	free(stepper->paths);
+	free(stepper->counts);
+}
+
+static bool append(IdList *list, const size_t *ids, size_t length) {
+	if (list->length + length > list->capacity) {
+		size_t newCapacity = (list->capacity > 0 ? list->capacity : INIT_SPACE);
+		while (newCapacity < list->length + length)
+			newCapacity *= 2;
+		size_t *tmp = realloc(list->ids, newCapacity * sizeof(size_t));
+		if (tmp == NULL)
+			return false;
+		list->ids = tmp;
+		list->capacity = newCapacity;
+	}
+	for (size_t i = 0; i < length; ++i)
+		list->ids[list->length + i] = ids[i];
+	list->length += length;
+	return true;
+}
+
+static bool bucketsEmpty(const Stepper *stepper, size_t bucket) {
+	for (unsigned i = 0; i < stepper->workerCount; ++i) {
+		if (stepper->buckets[(size_t) i * stepper->bucketCount + bucket % stepper->bucketCount].length > 0)
+			return false;
+	}
+	return true;
+}
+
+// moves the cities of a list of every worker to the frontier
+static bool gather(Stepper *stepper, IdList *lists, size_t stride) {
+	stepper->frontier.length = 0;
+	for (unsigned i = 0; i < stepper->workerCount; ++i) {
+		IdList *list = &lists[(size_t) i * stride];
+		if (!append(&stepper->frontier, list->ids, list->length))
+			return false;
+		list->length = 0;
+	}
+	return true;
+}
+
+static void run(Stepper *stepper, size_t count, PoolTask *task) {
+	if (stepper->pool) {
+		poolRun(stepper->pool, count, task, stepper);
+		return;
+	}
+	for (size_t i = 0; i < count; ++i)
+		task(stepper, 0, i);
+}
+
+// a city reached with a shorter distance is put in the bucket of that distance
+static bool relax(Stepper *stepper, unsigned worker, size_t cityId, bool light) {
+	City *city = stepper->cities[cityId];
+	const size_t distance = atomic_load_explicit(&stepper->distances[cityId], memory_order_relaxed);
+	const size_t roadCount = cityGetRoadCount(city);
+	for (size_t i = 0; i < roadCount; ++i) {
+		const unsigned length = roadGetLength(cityGetRoad(city, i));
+		if ((length <= stepper->delta) != light)
+			continue;
+		const size_t nextId = cityGetId(cityNeighbour(city, i));
+		const size_t nextDistance = distance + length;
+		size_t old = atomic_load_explicit(&stepper->distances[nextId], memory_order_relaxed);
+		while (nextDistance < old) {
+			if (atomic_compare_exchange_weak_explicit(&stepper->distances[nextId], &old, nextDistance,
+					memory_order_relaxed, memory_order_relaxed)) {
+				IdList *bucket = &stepper->buckets[(size_t) worker * stepper->bucketCount
+						+ nextDistance / stepper->delta % stepper->bucketCount];
+				if (!append(bucket, &nextId, 1))
+					return false;
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+// a city can be in the frontier more than once, it is taken once in a round
+static void relaxLight(void *context, unsigned worker, size_t index) {
+	Stepper *stepper = context;
+	const size_t end = (index + 1) * CHUNK < stepper->frontier.length ? (index + 1) * CHUNK : stepper->frontier.length;
+	for (size_t i = index * CHUNK; i < end; ++i) {
+		const size_t cityId = stepper->frontier.ids[i];
+		// left behind in a later bucket when a shorter distance was found
+		if (atomic_load_explicit(&stepper->distances[cityId], memory_order_relaxed) / stepper->delta != stepper->current)
+			continue;
+		if (atomic_exchange_explicit(&stepper->rounds[cityId], stepper->round, memory_order_relaxed) == stepper->round)
+			continue;
+		if (!atomic_exchange_explicit(&stepper->taken[cityId], true, memory_order_relaxed)
+				&& !append(&stepper->settled[worker], &cityId, 1))
+			atomic_store(&stepper->failed, true);
+		if (!relax(stepper, worker, cityId, true))
+			atomic_store(&stepper->failed, true);
+	}
+}
+
+static void relaxHeavy(void *context, unsigned worker, size_t index) {
+	Stepper *stepper = context;
+	const size_t end = (index + 1) * CHUNK < stepper->frontier.length ? (index + 1) * CHUNK : stepper->frontier.length;
+	for (size_t i = index * CHUNK; i < end; ++i) {
+		if (!relax(stepper, worker, stepper->frontier.ids[i], false))
+			atomic_store(&stepper->failed, true);
+	}
+}
+
+/* orders the cities of the bucket that was just emptied by distance, then
+ * finds their years, a distance at a time; the cities at a distance are
+ * split between the workers if there are many of them
+ */
+static bool sortBucket(Stepper *stepper, size_t start) {
+	const size_t length = stepper->order.length - start;
+	size_t *ids = stepper->order.ids + start;
+	const size_t base = stepper->current * stepper->delta;
+	if (length == 0)
+		return true;
+	for (size_t i = 0; i <= stepper->delta; ++i)
+		stepper->counts[i] = 0;
+	for (size_t i = 0; i < length; ++i)
+		++stepper->counts[atomic_load(&stepper->distances[ids[i]]) - base + 1];
+	for (size_t i = 1; i <= stepper->delta; ++i)
+		stepper->counts[i] += stepper->counts[i - 1];
+	// the frontier is free now, it holds the cities of the bucket while they are sorted
+	stepper->frontier.length = 0;
+	if (!append(&stepper->frontier, ids, length))
+		return false;
+	for (size_t i = 0; i < length; ++i) {
+		const size_t cityId = stepper->frontier.ids[i];
+		ids[stepper->counts[atomic_load(&stepper->distances[cityId]) - base]++] = cityId;
+	}
+	for (size_t first = 0; first < length;) {
+		const size_t distance = atomic_load(&stepper->distances[ids[first]]);
+		size_t last = first;
+		while (last < length && atomic_load(&stepper->distances[ids[last]]) == distance)
+			++last;
+		stepper->frontier.length = 0;
+		if (!append(&stepper->frontier, ids + first, last - first))
+			return false;
+		if (last - first >= CHUNK)
+			run(stepper, (last - first + CHUNK - 1) / CHUNK, finish);
+		else
+			finish(stepper, 0, 0);
+		first = last;
+	}
+	return true;
+}
+
+static void finish(void *context, unsigned worker, size_t index) {
+	Stepper *stepper = context;
+	(void) worker;
+	const size_t end = (index + 1) * CHUNK < stepper->frontier.length ? (index + 1) * CHUNK : stepper->frontier.length;
+	for (size_t i = index * CHUNK; i < end; ++i)
+		year(stepper, stepper->frontier.ids[i]);
+}
+
+// the years of a city from its neighbours on the shortest paths to it
+static void year(Stepper *stepper, size_t cityId) {
+	City *city = stepper->cities[cityId];
+	const size_t distance = atomic_load_explicit(&stepper->distances[cityId], memory_order_relaxed);
+	const size_t roadCount = cityGetRoadCount(city);
+	for (size_t i = 0; i < roadCount; ++i) {
+		Road *road = cityGetRoad(city, i);
+		const size_t previousId = cityGetId(cityNeighbour(city, i));
+		const size_t previous = atomic_load_explicit(&stepper->distances[previousId], memory_order_relaxed);
+		if (previous == UNREACHABLE || previous + roadGetLength(road) != distance)
+			continue;
+		const int roadYear = roadGetYear(road);
+		const int year1 = stepper->years[previousId], year2 = stepper->years2[previousId];
+		addYear(stepper, cityId, year1 < roadYear ? year1 : roadYear);
+		if (stepper->paths[previousId] > 1)
+			addYear(stepper, cityId, year2 < roadYear ? year2 : roadYear);
+	}
+}
+
+// adds the minimum year of one more shortest path, keeps the two highest
+static void addYear(Stepper *stepper, size_t cityId, int year) {
+	if (stepper->paths[cityId] == 0) {
+		stepper->years[cityId] = year;
+		stepper->paths[cityId] = 1;
+	} else if (year > stepper->years[cityId]) {
+		stepper->years2[cityId] = stepper->years[cityId];
+		stepper->years[cityId] = year;
+		stepper->paths[cityId] = 2;
+	} else if (stepper->paths[cityId] == 1 || year > stepper->years2[cityId]) {
+		stepper->years2[cityId] = year;
+		stepper->paths[cityId] = 2;
+	}
+}
+
+// a road can lead at most this many buckets further, plus the current one and a spare
+static size_t bucketCount(unsigned delta, unsigned longest) {
+	return (size_t) longest / delta + 2;
+}
+
+// a delta of 0 is taken as 1, a wide one is narrowed so that a bucket can be sorted by counting
+static unsigned width(unsigned delta) {
+	if (delta == 0)
+		return 1;
+	return delta < DELTA_LIMIT ? delta : DELTA_LIMIT;
+}
+//! @endcond
@@ -0,0 +1,17 @@
+/** @file
+ * Interface for a parallel search from one city to all others by delta-stepping.
+ */
+
+#ifndef MAP_STEPPING_H
+#define MAP_STEPPING_H
+
+#include <stdbool.h>
+#include "global_declarations.h"
+
+/// check if the roads are short enough for a delta-stepping search with buckets of a given width
+bool steppingFits(unsigned delta, unsigned longest);
+/// find the best paths from a city to every city of the map, split between the threads of the pool if it isn't NULL
+bool steppingDistances(Pool *pool, CityMap *cityMap, City *from, unsigned delta, unsigned longest,
+		CityDistance *distances);
+
+#endif //MAP_STEPPING_H
@@ -6,14 +6,20 @@
 #include <stdint.h>
 #include "city.h"
 #include "city_map.h"
+#include "exclusion.h"
+#include "positions.h"
 #include "road.h"
+#include "search.h"
 #include "trie.h"
 #include "trunk.h"
 
-#define ROUTE_NUMBER_MAX_LENGTH 3
+#define DETOUR_RADIUS 4
+#define ROUTE_NUMBER_MAX_LENGTH 10
 
 /** A structure used to store information about paths on the road map.
- * Mostly used by Routes.
+ * Mostly used by Routes. The trunk of a Route knows the positions of its
+ * cities and roads, so checking if it goes through a city, or finding where
+ * a detour goes, takes constant time.
  */
 struct Trunk {
 	/// id of a Route using this trunk
@@ -28,33 +34,36 @@ struct Trunk {
 	City *last;
 	/// roads making up the trunk, ordered
 	Road **roads;
+	/// the cities along the trunk from the first one, NULL unless it belongs to a Route
+	Positions *cities;
+	/// the same roads as in roads, with their positions, NULL unless it belongs to a Route
+	Positions *roadPositions;
 };
 
 static bool isDecoy(const Trunk *trunk);
-static bool reserve(Road *const *roads, size_t count);
+static bool locate(Trunk *trunk);
+static bool reserve(Road *const *roads, size_t count, unsigned extra);
+static int compareRoads(const void *a, const void *b);
 static int getMinYear(const Trunk *trunk);
 static size_t descriptionLength(const Trunk *trunk);
 static size_t sumOfRoads(const Trunk *trunk);
 static void append(Trunk *prefix, Trunk *suffix, Trunk *result);
-static void block(Trunk *trunk);
+static void block(Exclusion *exclusion, Trunk *trunk);
 static void merge(Trunk *result, Trunk *base, Trunk *infix);
-static void unblock(Trunk *trunk);
 static City *getCity(Trunk *trunk, size_t position);
 static Trunk decoy(void);
-static Trunk *makeDetour(CityMap *cityMap, Trunk *trunk, Road *road);
+static Trunk *makeDetour(CityMap *cityMap, Trunk *trunk, Road *road, Search *search);
 static Trunk *rebuild(Trunk *ans, Trunk *base, size_t length);
 static Trunk *join(Trunk *trunk, Trunk *extension);
 static Trunk *chooseExtension(Trunk **pTrunk1, Trunk **pTrunk2);
-static Trunk *makeExtension(CityMap *cityMap, Trunk *trunk, City *city);
+static Trunk *makeExtension(CityMap *cityMap, Trunk *trunk, City *city, Search *search);
+static Trunk *makePath(City *from, City *to, CityMap *m, Search *search, unsigned trunkId);
+static Trunk *wrap(City *from, City *to, Road **roads, size_t length, unsigned trunkId);
+static void reverse(Road **roads, size_t length);
 
 bool trunkHasCity(const Trunk *trunk, const City *city) {
-	for (size_t i = 0; i < trunk->length; ++i) {
-		City *city1, *city2;
-		roadGetCities(trunk->roads[i], &city1, &city2);
-		if (city1 == city || city == city2)
-			return true;
-	}
-	return false;
+	assert(trunk->cities);
+	return positionsFind(trunk->cities, city) != SIZE_MAX;
 }
 
 char *trunkDescription(const Trunk *const trunk) {
@@ -84,47 +93,61 @@ char *trunkDescription(const Trunk *const trunk) {
 	return ans;
 }
 
+// a road gets room only for the trunks that aren't recorded on it yet
+bool trunkReserveAll(Trunk *const *trunks, size_t count) {
+	size_t total = 0, length = 0;
+	for (size_t i = 0; i < count; ++i)
+		total += trunks[i]->length;
+	Road **roads = malloc(total * sizeof(Road *) + 1);
+	if (!roads)
+		return false;
+	for (size_t i = 0; i < count; ++i) {
+		for (size_t j = 0; j < trunks[i]->length; ++j) {
+			if (!roadHasRoute(trunks[i]->roads[j], trunks[i]->id))
+				roads[length++] = trunks[i]->roads[j];
+		}
+	}
+	qsort(roads, length, sizeof(Road *), compareRoads);
+	bool ans = true;
+	for (size_t i = 0, j; ans && i < length; i = j) {
+		for (j = i + 1; j < length && roads[j] == roads[i]; ++j);
+		ans = roadReserve(roads[i], (unsigned) (j - i));
+	}
+	free(roads);
+	return ans;
+}
+
 void trunkAttach(Trunk *trunk) {
 	for (size_t i = 0; i < trunk->length; ++i)
 		roadTrunkAdd(trunk->roads[i], trunk->id);
 }
 
-Trunk *trunkBuild(City *from, City *to, CityMap *m, unsigned trunkId) {
-	Trunk *ans = calloc(1, sizeof(Trunk));
-	if (ans) {
-		*ans = (Trunk) {
-			.first = from,
-			.last = to,
-			.id = trunkId,
-		};
-		ans->roads = cityPath(from, to, m, &ans->length);
-		if (isDecoy(ans)) // no route
-			return ans;
-		if (ans->roads) {
-			if (reserve(ans->roads, ans->length))
-				return ans;
-			free(ans->roads);
-		}
-		free(ans);
-	}
-	return NULL;
+Trunk *trunkBuild(City *from, City *to, CityMap *m, Search *search, unsigned trunkId) {
+	Trunk *ans = makePath(from, to, m, search, trunkId);
+	if (ans && !isDecoy(ans) && (!reserve(ans->roads, ans->length, 1) || !locate(ans)))
+		trunkFree(&ans);
+	return ans;
 }
 
-Trunk *trunkAddDetour(CityMap *cityMap, Trunk *trunk, Road *road) {
+// changes nothing outside of the search, detours of many Routes may be made at once
+Trunk *trunkAddDetour(CityMap *cityMap, Trunk *trunk, Road *road, Search *search) {
 	Trunk *ans = calloc(1, sizeof(Trunk));
 	assert(trunk);
 	if (ans) {
-		Trunk *detour = makeDetour(cityMap, trunk, road);
+		Trunk *detour = makeDetour(cityMap, trunk, road, search);
 		if (detour) {
 			if (!isDecoy(detour)) {
 				rebuild(ans, trunk, detour->length + trunk->length - 1);
 				if (ans->roads) {
 					merge(ans, trunk, detour);
 					trunkFree(&detour);
-					assert(ans->id < ROUTE_LIMIT);
 					assert(roadHasCity(ans->roads[0], ans->first));
 					assert(roadHasCity(ans->roads[ans->length - 1], ans->last));
-					return ans;
+					if (locate(ans))
+						return ans;
+					free(ans->roads);
+					free(ans);
+					return NULL;
 				}
 			}
 			trunkFree(&detour);
@@ -134,11 +157,13 @@ Trunk *trunkAddDetour(CityMap *cityMap, Trunk *trunk, Road *road) {
 	return NULL;
 }
 
-Trunk *trunkExtend(CityMap *cityMap, Trunk *trunk, City *city) {
+Trunk *trunkExtend(CityMap *cityMap, Trunk *trunk, City *city, Search *search) {
 	Trunk *extension;
-	block(trunk);
-	extension = makeExtension(cityMap, trunk, city);
-	unblock(trunk);
+	Exclusion *exclusion = searchExclusion(search);
+	if (!exclusionReset(exclusion, cityMapGetLength(cityMap)))
+		return NULL;
+	block(exclusion, trunk);
+	extension = makeExtension(cityMap, trunk, city, search);
 	if (extension) {
 		if (!isDecoy(extension))
 			return join(trunk, extension);
@@ -153,6 +178,10 @@ void trunkFree(Trunk **pTrunk) {
 	*pTrunk = NULL;
 	if (!isDecoy(trunk))
 		free(trunk->roads);
+	if (trunk->cities)
+		positionsDestroy(&trunk->cities);
+	if (trunk->roadPositions)
+		positionsDestroy(&trunk->roadPositions);
 	free(trunk);
 }
 
@@ -165,6 +194,10 @@ void trunkDestroy(Trunk **pTrunk) {
 	for (size_t i = 0; i < trunk->length; ++i)
 		roadTrunkRemove(trunk->roads[i], trunk->id);
 	free(trunk->roads);
+	if (trunk->cities)
+		positionsDestroy(&trunk->cities);
+	if (trunk->roadPositions)
+		positionsDestroy(&trunk->roadPositions);
 	free(*pTrunk);
 	*pTrunk = NULL;
 }
@@ -210,7 +243,10 @@ Trunk *trunkMake(Trie *trie, unsigned id, NameList list) {
 			assert(road);
 			ans->roads[i] = road;
 		}
-		return ans;
+		if (locate(ans))
+			return ans;
+		free(ans->roads);
+		free(ans);
 	}
 	return NULL;
 }
@@ -236,6 +272,8 @@ static Trunk *join(Trunk *trunk, Trunk *extension) {
 	if (ans) {
 		ans->length = trunk->length + extension->length;
 		ans->roads = malloc(ans->length * sizeof(City *));
+		ans->cities = NULL;
+		ans->roadPositions = NULL;
 		if (ans->roads) {
 			if (trunk->last == extension->first)
 				append(trunk, extension, ans);
@@ -244,44 +282,84 @@ static Trunk *join(Trunk *trunk, Trunk *extension) {
 			ans->id = trunk->id;
 			assert(ans->id == extension->id);
 			trunkFree(&extension);
-			return ans;
+			if (locate(ans))
+				return ans;
+			free(ans->roads);
+			free(ans);
+			return NULL;
 		}
 		free(ans);
-		trunkFree(&extension);
 	}
+	trunkFree(&extension);
 	return NULL;
 }
 
 static size_t getPosition(Trunk *trunk, Road *road) {
-	for (size_t i = 0; i < trunk->length; ++i)
-		if (trunk->roads[i] == road)
-			return i;
-	assert(false);
-	return trunk->length;
+	assert(trunk->roadPositions);
+	const size_t ans = positionsFind(trunk->roadPositions, road);
+	assert(ans != SIZE_MAX);
+	return ans;
 }
 
-static Trunk *makeDetour(CityMap *cityMap, Trunk *trunk, Road *road) {
+static Trunk *makeDetour(CityMap *cityMap, Trunk *trunk, Road *road, Search *search) {
 	size_t position = getPosition(trunk, road);
-	unsigned length;
+	Exclusion *exclusion = searchExclusion(search);
 	City *from, *to;
 	assert(trunkTest(trunk));
 	from = getCity(trunk, position);
 	to = getCity(trunk, 1 + position);
-	Trunk *ans;
-	block(trunk);
-	length = roadBlock(road);
-	ans = trunkBuild(from, to, cityMap, trunk->id);
-	roadUnblock(road, length);
-	unblock(trunk);
-	return ans;
+	if (!exclusionReset(exclusion, cityMapGetLength(cityMap)))
+		return NULL;
+	block(exclusion, trunk);
+	exclusionUnblock(exclusion, from);
+	exclusionUnblock(exclusion, to);
+	exclusionBlockRoad(exclusion, road);
+	// most detours are short, a search within a few lengths of the road finds them without going far
+	size_t length;
+	Road **roads = searchPathWithin(search, from, to, cityMap, DETOUR_RADIUS * (size_t) roadGetLength(road), &length);
+	return wrap(from, to, roads, length, trunk->id);
+}
+
+// the roads aren't reserved for the Route, a decoy is returned if there is no path
+static Trunk *makePath(City *from, City *to, CityMap *m, Search *search, unsigned trunkId) {
+	size_t length;
+	Road **roads = searchPath(search, from, to, m, &length);
+	return wrap(from, to, roads, length, trunkId);
+}
+
+// takes over the roads found by a search, they are freed if there is no memory
+static Trunk *wrap(City *from, City *to, Road **roads, size_t length, unsigned trunkId) {
+	if (length == 0)
+		return NULL;
+	Trunk *ans = malloc(sizeof(Trunk));
+	if (ans) {
+		*ans = (Trunk) {
+			.first = from,
+			.last = to,
+			.id = trunkId,
+			.length = length,
+			.roads = roads,
+			.cities = NULL,
+			.roadPositions = NULL,
+		};
+		return ans;
+	}
+	free(roads);
+	return NULL;
+}
+
+static void reverse(Road **roads, size_t length) {
+	for (size_t i = 0; i < length / 2; ++i) {
+		Road *tmp = roads[i];
+		roads[i] = roads[length - 1 - i];
+		roads[length - 1 - i] = tmp;
+	}
 }
 
 static void merge(Trunk *result, Trunk *base, Trunk *infix) {
-	size_t detourStart;
 	assert(infix->first != NULL && infix->last != NULL);
-	for (detourStart = 0; true; ++detourStart)
-		if (infix->first == getCity(base, detourStart))
-			break;
+	const size_t detourStart = positionsFind(base->cities, infix->first);
+	assert(detourStart < base->length);
 	for (size_t i = 0; i < result->length; ++i) {
 		if (i < detourStart)
 			result->roads[i] = base->roads[i];
@@ -301,32 +379,50 @@ void append(Trunk *prefix, Trunk *suffix, Trunk *result) {
 	result->last = suffix->last;
 }
 
-static Trunk *makeExtension(CityMap *cityMap, Trunk *trunk, City *city) {
-	Trunk *trunk1, *trunk2;
-	cityUnblock(trunk->first);
-	trunk1 = trunkBuild(city, trunk->first, cityMap, trunk->id);
-	cityBlock(trunk->first);
-	if (trunk1 == NULL)
-		return NULL;
-	cityUnblock(trunk->last);
-	trunk2 = trunkBuild(trunk->last, city, cityMap, trunk->id);
-	cityBlock(trunk->last);
-	if (trunk2 == NULL) {
+/* a single search from the city finds paths to both ends of the Route, the
+ * path to the last city is then reversed
+ */
+static Trunk *makeExtension(CityMap *cityMap, Trunk *trunk, City *city, Search *search) {
+	Road **paths[2];
+	size_t lengths[2];
+	Exclusion *exclusion = searchExclusion(search);
+	exclusionUnblock(exclusion, trunk->first);
+	exclusionUnblock(exclusion, trunk->last);
+	searchPathPair(search, city, trunk->first, trunk->last, cityMap, paths, lengths);
+	exclusionBlock(exclusion, trunk->first);
+	exclusionBlock(exclusion, trunk->last);
+	if (paths[1])
+		reverse(paths[1], lengths[1]);
+	Trunk *trunk1 = wrap(city, trunk->first, paths[0], lengths[0], trunk->id);
+	Trunk *trunk2 = wrap(trunk->last, city, paths[1], lengths[1], trunk->id);
+	if (trunk1 && !isDecoy(trunk1) && !reserve(trunk1->roads, trunk1->length, 1))
 		trunkFree(&trunk1);
-		return NULL;
-	}
-	return chooseExtension(&trunk1, &trunk2);
+	if (trunk2 && !isDecoy(trunk2) && !reserve(trunk2->roads, trunk2->length, 1))
+		trunkFree(&trunk2);
+	if (trunk1 && trunk2)
+		return chooseExtension(&trunk1, &trunk2);
+	if (trunk1)
+		trunkFree(&trunk1);
+	if (trunk2)
+		trunkFree(&trunk2);
+	return NULL;
 }
 
-static bool reserve(Road *const *roads, const size_t count) {
+static bool reserve(Road *const *roads, const size_t count, unsigned extra) {
 	for (size_t i = 0; i < count; ++i) {
-		bool reserveSuccess = roadReserve(roads[i]);
+		bool reserveSuccess = roadReserve(roads[i], extra);
 		if (reserveSuccess == false)
 			return false;
 	}
 	return true;
 }
 
+static int compareRoads(const void *a, const void *b) {
+	uintptr_t road1 = (uintptr_t) *(Road *const *) a;
+	uintptr_t road2 = (uintptr_t) *(Road *const *) b;
+	return (road1 > road2) - (road1 < road2);
+}
+
 static Trunk *rebuild(Trunk *const ans, Trunk *base, size_t length) {
 	assert(length != SIZE_MAX);
 	*ans = (Trunk) {
@@ -354,17 +450,8 @@ static size_t sumOfRoads(const Trunk *trunk) {
 }
 
 static City *getCity(Trunk *trunk, size_t position) {
-	Road *road1, *road2;
-	if (position == 0) {
-		return trunk->first;
-	}
-	if (position == trunk->length) {
-		return trunk->last;
-	}
-	road1 = trunk->roads[position - 1];
-	road2 = trunk->roads[position];
-	return roadIntersect(road1, road2);
-
+	assert(trunk->cities && position <= trunk->length);
+	return positionsGet(trunk->cities, position);
 }
 
 Trunk *chooseExtension(Trunk **pTrunk1, Trunk **pTrunk2) {
@@ -443,25 +530,33 @@ static bool isDecoy(const Trunk *trunk) {
 	}
 }
 
-
-static void unblock(Trunk *trunk) {
-	for (size_t i = 0; i < trunk->length; i += 2) {
-		City *city1, *city2;
-		roadGetCities(trunk->roads[i], &city1, &city2);
-		cityUnblock(city1);
-		cityUnblock(city2);
-	}
-	if (trunk->length % 2 == 0)
-		cityUnblock(trunk->last);
+static void block(Exclusion *exclusion, Trunk *trunk) {
+	assert(trunk->cities);
+	const size_t cityCount = positionsCount(trunk->cities);
+	for (size_t i = 0; i < cityCount; ++i)
+		exclusionBlock(exclusion, positionsGet(trunk->cities, i));
 }
 
-static void block(Trunk *trunk) {
-	for (size_t i = 0; i < trunk->length; i += 2) {
+// records the cities and roads along the trunk in order, a Route doesn't go through a city twice
+static bool locate(Trunk *trunk) {
+	trunk->cities = positionsInit(trunk->length + 1);
+	if (trunk->cities == NULL)
+		return false;
+	trunk->roadPositions = positionsInit(trunk->length);
+	if (trunk->roadPositions == NULL) {
+		positionsDestroy(&trunk->cities);
+		return false;
+	}
+	for (size_t i = 0; i < trunk->length; ++i)
+		positionsAppend(trunk->roadPositions, trunk->roads[i]);
+	City *current = trunk->first;
+	positionsAppend(trunk->cities, current);
+	for (size_t i = 0; i < trunk->length; ++i) {
 		City *city1, *city2;
 		roadGetCities(trunk->roads[i], &city1, &city2);
-		cityBlock(city1);
-		cityBlock(city2);
+		current = (city1 == current ? city2 : city1);
+		positionsAppend(trunk->cities, current);
 	}
-	if (trunk->length % 2 == 0)
-		cityBlock(trunk->last);
+	assert(current == trunk->last);
+	return true;
 }
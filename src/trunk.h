@@ -10,6 +10,8 @@
 
 /// check if a trunk goes through a given city
 bool trunkHasCity(const Trunk *trunk, const City *city);
+/// prepare the roads of many trunks for being attached at once
+bool trunkReserveAll(Trunk *const *trunks, size_t count);
 /// debug function, check invariants within a trunk
 bool trunkTest(const Trunk *trunk);
 /// provide a string description of a Route
@@ -25,11 +27,11 @@ void trunkDestroy(Trunk **pTrunk);
 /// release used resources and set pointer to NULL
 void trunkFree(Trunk **pTrunk);
 /// replace a removed road in a trunk with a detour section
-Trunk *trunkAddDetour(CityMap *cityMap, Trunk *trunk, Road *road);
+Trunk *trunkAddDetour(CityMap *cityMap, Trunk *trunk, Road *road, Search *search);
 /// create a Trunk from one city to another
-Trunk *trunkBuild(City *from, City *to, CityMap *m, unsigned trunkId);
+Trunk *trunkBuild(City *from, City *to, CityMap *m, Search *search, unsigned trunkId);
 /// extend a trunk to reach a city
-Trunk *trunkExtend(CityMap *cityMap, Trunk *trunk, City *c);
+Trunk *trunkExtend(CityMap *cityMap, Trunk *trunk, City *c, Search *search);
 /// initialize a Trunk structure
 Trunk *trunkMake(Trie *trie, unsigned id, NameList list);
 
@@ -0,0 +1,23 @@
+/** @file
+ * Checks shared by the tests: a failed check is reported on the standard
+ * error and makes the test program exit with a nonzero code.
+ */
+
+#ifndef MAP_CHECK_H
+#define MAP_CHECK_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+//! @cond
+static int failures = 0;
+
+static inline void check(bool condition, const char *what) {
+	if (!condition) {
+		fprintf(stderr, "failed: %s\n", what);
+		++failures;
+	}
+}
+//! @endcond
+
+#endif //MAP_CHECK_H
@@ -0,0 +1,33 @@
+/** @file
+ * Checks that the index of connected parts follows removed roads.
+ *
+ * Removing a road of a cycle keeps its ends connected, so the index is kept;
+ * removing the only road to a city splits it off, so the index is built
+ * again. Either way Routes have to be found exactly where there are paths.
+ */
+
+#include "check.h"
+#include "map.h"
+
+int main(void) {
+	Map *map = newMap();
+	check(map != NULL, "map created");
+	if (!map)
+		return 1;
+	check(addRoad(map, "A", "B", 1, 2000), "add A-B");
+	check(addRoad(map, "B", "C", 1, 2000), "add B-C");
+	check(addRoad(map, "C", "D", 1, 2000), "add C-D");
+	check(addRoad(map, "D", "A", 1, 2000), "add D-A");
+	check(addRoad(map, "D", "E", 1, 2000), "add D-E");
+	check(addRoad(map, "X", "Y", 1, 2000), "add X-Y");
+	check(!newRoute(map, 1, "A", "X"), "no Route between parts");
+	check(removeRoad(map, "A", "B"), "remove a road of the cycle");
+	check(newRoute(map, 1, "A", "B"), "Route around the cycle");
+	check(removeRoad(map, "D", "E"), "remove the road to E");
+	check(!newRoute(map, 2, "A", "E"), "no Route to the split off city");
+	check(addRoad(map, "E", "X", 1, 2000), "add E-X");
+	check(newRoute(map, 2, "E", "Y"), "Route through the joined parts");
+	check(!newRoute(map, 3, "A", "Y"), "no Route between the other parts");
+	deleteMap(map);
+	return failures == 0 ? 0 : 1;
+}
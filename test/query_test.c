@@ -0,0 +1,106 @@
+/** @file
+ * Checks the queries run by steps through the map interface.
+ *
+ * A query run a city at a time, with Routes made in between, has to find
+ * the same path as a search of the whole map. A query fails if the map
+ * changes, another query begins or its deadline passes, and the queries
+ * after it aren't affected.
+ */
+
+#include <stdio.h>
+#include "check.h"
+#include "map.h"
+
+#define SIDE 8
+#define NAME_LENGTH 16
+
+//! @cond
+static void name(char *dest, unsigned x, unsigned y) {
+	snprintf(dest, NAME_LENGTH, "c%u_%u", x, y);
+}
+
+static bool build(Map *map) {
+	char a[NAME_LENGTH], b[NAME_LENGTH];
+	for (unsigned x = 0; x < SIDE; ++x) {
+		for (unsigned y = 0; y < SIDE; ++y) {
+			name(a, x, y);
+			if (x + 1 < SIDE) {
+				name(b, x + 1, y);
+				if (!addRoad(map, a, b, 1 + (x * 7 + y * 3) % 5, 1990 + (int) ((x + y) % 9)))
+					return false;
+			}
+			if (y + 1 < SIDE) {
+				name(b, x, y + 1);
+				if (!addRoad(map, a, b, 1 + (x * 5 + y * 11) % 4, 1995 + (int) ((x * y) % 7)))
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+// runs the query to the end and checks its result against the search of the whole map
+static void checkResult(MapQuery *query, const CityDistance *expected, const char *what) {
+	CityDistance path;
+	while (!mapQueryStep(query, 1))
+		continue;
+	check(mapQueryResult(query, &path), what);
+	if (expected->unique)
+		check(path.distance == expected->distance && path.year == expected->year, what);
+	else
+		check(path.distance == SIZE_MAX, what);
+}
+//! @endcond
+
+int main(void) {
+	char last[NAME_LENGTH];
+	CityDistance distances[SIDE * SIDE], path;
+	struct timespec past = {.tv_sec = 0, .tv_nsec = 0};
+	Map *map = newMap();
+	check(map != NULL && build(map), "map created");
+	if (!map)
+		return 1;
+	name(last, SIDE - 1, SIDE - 1);
+	check(mapDistancesFrom(map, "c0_0", distances), "distances found");
+	const CityDistance *expected = &distances[mapCityId(map, last)];
+
+	MapQuery *query = mapQueryBegin(map, "c0_0", last, NULL);
+	check(query != NULL, "query begun");
+	size_t steps = 0;
+	for (unsigned id = 1; query && !mapQueryStep(query, 1); ++id, ++steps)
+		newRoute(map, id % 20 + 1, "c0_0", id % 2 ? "c3_4" : last);
+	check(steps > 1, "query run by steps");
+	check(query && mapQueryResult(query, &path), "query with other commands in between");
+	if (expected->unique)
+		check(path.distance == expected->distance && path.year == expected->year, "the best path found");
+	mapQueryDelete(query);
+
+	// the result of a query is cached, so the next ones go elsewhere
+	query = mapQueryBegin(map, "c0_0", "c7_0", NULL);
+	check(query && !mapQueryStep(query, 1), "query in progress");
+	check(addRoad(map, "c0_0", "far", 1, 2000), "map changed");
+	check(query && mapQueryDone(query) && !mapQueryResult(query, &path), "query fails after a change");
+	mapQueryDelete(query);
+
+	query = mapQueryBegin(map, "c0_0", last, NULL);
+	MapQuery *other = mapQueryBegin(map, "c0_0", last, NULL);
+	check(query && mapQueryDone(query) && !mapQueryResult(query, &path), "query fails after another one");
+	mapQueryDelete(query);
+	if (other)
+		checkResult(other, expected, "query begun last");
+	mapQueryDelete(other);
+
+	query = mapQueryBegin(map, "c0_0", "c0_7", &past);
+	check(query && mapQueryStep(query, 1) && !mapQueryResult(query, &path), "query fails after the deadline");
+	mapQueryDelete(query);
+	query = mapQueryBegin(map, "c0_0", last, NULL);
+	mapQueryDelete(query);
+	query = mapQueryBegin(map, "c0_0", "c0_7", NULL);
+	if (query)
+		checkResult(query, &distances[mapCityId(map, "c0_7")], "query after failed ones");
+	mapQueryDelete(query);
+
+	check(mapQueryBegin(map, "c0_0", "none", NULL) == NULL, "no query to a missing city");
+	deleteMap(map);
+	return failures == 0 ? 0 : 1;
+}
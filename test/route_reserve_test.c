@@ -0,0 +1,49 @@
+/** @file
+ * Checks that removing a road reserves room for Route ids only on the roads
+ * of the detours.
+ *
+ * Three Routes go A-B-C-D, the road B-C is removed and the Routes take the
+ * detour B-X-C. The roads A-B and C-D are used by the same Routes as before,
+ * so their ids have to stay stored inside the road.
+ */
+
+#include "check.h"
+#include "map.h"
+#include "map_internal.h"
+#include "road.h"
+#include "route_set.h"
+
+#define ROUTE_COUNT 3
+
+//! @cond
+static void checkRoad(Map *map, const char *city1, const char *city2) {
+	Road *road = mapGetRoad(map, city1, city2);
+	check(road != NULL, "road exists");
+	if (road) {
+		const RouteSet *routes = roadGetRoutes(road);
+		check(routeSetCount(routes) == ROUTE_COUNT, "road keeps its Routes");
+		check(routes->capacity == 0, "road stores its Routes inline");
+	}
+}
+//! @endcond
+
+int main(void) {
+	Map *map = newMap();
+	check(map != NULL, "map created");
+	if (!map)
+		return 1;
+	check(addRoad(map, "A", "B", 1, 2000), "add A-B");
+	check(addRoad(map, "B", "C", 1, 2000), "add B-C");
+	check(addRoad(map, "C", "D", 1, 2000), "add C-D");
+	check(addRoad(map, "B", "X", 5, 2000), "add B-X");
+	check(addRoad(map, "X", "C", 5, 2000), "add X-C");
+	for (unsigned id = 1; id <= ROUTE_COUNT; ++id)
+		check(newRoute(map, id, "A", "D"), "add Route");
+	check(removeRoad(map, "B", "C"), "remove B-C");
+	checkRoad(map, "A", "B");
+	checkRoad(map, "C", "D");
+	checkRoad(map, "B", "X");
+	checkRoad(map, "X", "C");
+	deleteMap(map);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/** @file
+ * Checks the Routes chosen by the map against the rules of the path search.
+ *
+ * The shortest path wins; among the shortest, the one whose oldest road is
+ * the newest. If that leaves a tie, the Route can't be created. Detours and
+ * extensions may not go through the other cities of their Route. Every
+ * scenario is run with each way of preparing the search.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "map.h"
+
+/// number of cities on a side of the grid scenario
+#define GRID_SIZE 4
+
+//! @cond
+typedef struct Setting {
+	const char *name;
+	bool (*prepare)(Map *map);
+} Setting;
+
+static bool shortRoads(Map *map) {
+	(void) map;
+	return true;
+}
+
+static bool longRoad(Map *map) {
+	return addRoad(map, "X1", "X2", 5000, 2000);
+}
+
+static bool landmarks(Map *map) {
+	return mapPrepareLandmarks(map, 2);
+}
+
+static bool overlay(Map *map) {
+	return mapPrepareOverlay(map, 3);
+}
+
+static bool workers(Map *map) {
+	return mapPrepareWorkers(map, 3);
+}
+
+static const Setting settings[] = {
+	{"short roads", shortRoads},
+	{"a long road elsewhere", longRoad},
+	{"landmarks", landmarks},
+	{"overlay", overlay},
+	{"workers", workers},
+};
+
+static void add(Map *map, const char *city1, const char *city2, unsigned length, int year) {
+	check(addRoad(map, city1, city2, length, year), "road added");
+}
+
+static void checkRoute(Map *map, unsigned routeId, const char *expected) {
+	const char *description = getRouteDescription(map, routeId);
+	check(description != NULL && strcmp(description, expected) == 0, expected);
+	free((void *) description);
+}
+
+static void ties(Map *map, const Setting *setting) {
+	add(map, "A", "B", 1, 2000);
+	add(map, "B", "D", 1, 2000);
+	add(map, "A", "C", 1, 2000);
+	add(map, "C", "D", 1, 2000);
+	check(setting->prepare(map), "search prepared");
+	check(!newRoute(map, 1, "A", "D"), "equal paths make a Route fail");
+	check(repairRoad(map, "C", "D", 2001), "road repaired");
+	check(!newRoute(map, 1, "A", "D"), "equal oldest roads make a Route fail");
+	check(repairRoad(map, "A", "C", 2001), "road repaired");
+	check(repairRoad(map, "A", "B", 2010), "road repaired");
+	check(newRoute(map, 2, "A", "D"), "the newest oldest road wins");
+	checkRoute(map, 2, "2;A;1;2001;C;1;2001;D");
+	add(map, "P", "Q", 1, 2000);
+	add(map, "Q", "S", 1, 2020);
+	add(map, "P", "R", 1, 2000);
+	add(map, "R", "S", 1, 2030);
+	check(!newRoute(map, 3, "P", "S"), "newer other roads don't break a tie");
+	add(map, "P", "S", 2, 2040);
+	check(newRoute(map, 3, "P", "S"), "a third path breaks the tie");
+	checkRoute(map, 3, "3;P;2;2040;S");
+}
+
+static void detours(Map *map, const Setting *setting) {
+	add(map, "A", "B", 1, 2000);
+	add(map, "B", "C", 1, 2000);
+	add(map, "C", "D", 1, 2000);
+	add(map, "B", "Y", 2, 2005);
+	add(map, "Y", "C", 2, 2005);
+	add(map, "B", "Z", 2, 2005);
+	add(map, "Z", "C", 2, 2005);
+	check(setting->prepare(map), "search prepared");
+	check(newRoute(map, 1, "A", "D"), "Route created");
+	checkRoute(map, 1, "1;A;1;2000;B;1;2000;C;1;2000;D");
+	// the shortest detour goes through A, which is on the Route
+	add(map, "A", "W", 1, 2010);
+	add(map, "W", "C", 1, 2010);
+	check(!removeRoad(map, "B", "C"), "equal detours keep the road");
+	checkRoute(map, 1, "1;A;1;2000;B;1;2000;C;1;2000;D");
+	check(repairRoad(map, "Z", "C", 2006), "road repaired");
+	check(repairRoad(map, "B", "Z", 2006), "road repaired");
+	check(removeRoad(map, "B", "C"), "road removed");
+	checkRoute(map, 1, "1;A;1;2000;B;2;2006;Z;2;2006;C;1;2000;D");
+}
+
+static void extensions(Map *map, const Setting *setting) {
+	detours(map, setting);
+	add(map, "A", "E", 2, 2001);
+	add(map, "D", "E", 2, 2001);
+	check(!extendRoute(map, 1, "E"), "equal extensions make the Route stay");
+	add(map, "A", "F", 2, 2001);
+	add(map, "D", "F", 2, 2002);
+	check(extendRoute(map, 1, "F"), "Route extended");
+	checkRoute(map, 1, "1;F;2;2001;A;1;2000;B;2;2006;Z;2;2006;C;1;2000;D");
+	// the path from F goes through A, so only the one from D is left
+	add(map, "A", "G", 1, 2001);
+	add(map, "G", "H", 1, 2001);
+	add(map, "D", "H", 2, 2001);
+	check(extendRoute(map, 1, "H"), "Route extended");
+	checkRoute(map, 1, "1;F;2;2001;A;1;2000;B;2;2006;Z;2;2006;C;1;2000;D;2;2001;H");
+}
+
+static void sharedRoad(Map *map, const Setting *setting) {
+	add(map, "A", "B", 1, 2000);
+	add(map, "B", "C", 1, 2000);
+	add(map, "C", "D", 1, 2000);
+	add(map, "E", "B", 1, 2001);
+	add(map, "C", "F", 1, 2002);
+	add(map, "B", "Y", 2, 2005);
+	add(map, "Y", "C", 2, 2005);
+	add(map, "B", "Z", 2, 2006);
+	add(map, "Z", "C", 2, 2006);
+	check(setting->prepare(map), "search prepared");
+	check(newRoute(map, 1, "A", "D"), "Route created");
+	check(newRoute(map, 2, "E", "F"), "Route created");
+	check(newRoute(map, 3, "A", "F"), "Route created");
+	check(newRoute(map, 4, "E", "D"), "Route created");
+	add(map, "A", "W", 1, 2010);
+	add(map, "W", "C", 1, 2010);
+	check(removeRoad(map, "B", "C"), "road removed");
+	checkRoute(map, 1, "1;A;1;2000;B;2;2006;Z;2;2006;C;1;2000;D");
+	checkRoute(map, 2, "2;E;1;2001;B;1;2000;A;1;2010;W;1;2010;C;1;2002;F");
+	checkRoute(map, 3, "3;A;1;2000;B;2;2006;Z;2;2006;C;1;2002;F");
+	checkRoute(map, 4, "4;E;1;2001;B;1;2000;A;1;2010;W;1;2010;C;1;2000;D");
+}
+
+static void gridName(char *name, int x, int y) {
+	sprintf(name, "g%d_%d", x, y);
+}
+
+static void grid(Map *map, const Setting *setting) {
+	char city1[16], city2[16];
+	for (int x = 0; x < GRID_SIZE; ++x) {
+		for (int y = 0; y < GRID_SIZE; ++y) {
+			gridName(city1, x, y);
+			if (x + 1 < GRID_SIZE) {
+				gridName(city2, x + 1, y);
+				add(map, city1, city2, 1 + (x * 7 + y * 3) % 3, 2000 + (x + 2 * y) % 4);
+			}
+			if (y + 1 < GRID_SIZE) {
+				gridName(city2, x, y + 1);
+				add(map, city1, city2, 1 + (x * 5 + y) % 3, 2000 + (3 * x + y) % 4);
+			}
+		}
+	}
+	check(setting->prepare(map), "search prepared");
+	check(newRoute(map, 1, "g0_0", "g3_3"), "Route created");
+	check(!newRoute(map, 2, "g3_0", "g0_3"), "equal paths make a Route fail");
+	check(newRoute(map, 3, "g0_1", "g3_2"), "Route created");
+	check(!newRoute(map, 4, "g1_0", "g2_3"), "equal paths make a Route fail");
+	check(newRoute(map, 5, "g0_0", "g3_0"), "Route created");
+	check(newRoute(map, 6, "g0_3", "g3_3"), "Route created");
+	checkRoute(map, 1, "1;g0_0;1;2000;g0_1;1;2002;g1_1;1;2000;g1_2;2;2001;g2_2;1;2000;g2_3;3;2000;g3_3");
+	checkRoute(map, 3, "3;g0_1;1;2002;g1_1;1;2000;g1_2;2;2001;g2_2;3;2002;g3_2");
+	checkRoute(map, 5, "5;g0_0;1;2000;g1_0;2;2001;g2_0;3;2002;g3_0");
+	checkRoute(map, 6, "6;g0_3;1;2002;g1_3;2;2003;g2_3;3;2000;g3_3");
+}
+
+static void (*const scenarios[])(Map *map, const Setting *setting) = {ties, detours, grid, sharedRoad, extensions};
+//! @endcond
+
+int main(void) {
+	for (size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); ++i) {
+		for (size_t j = 0; j < sizeof(scenarios) / sizeof(scenarios[0]); ++j) {
+			Map *map = newMap();
+			check(map != NULL, "map created");
+			if (!map)
+				return 1;
+			int previous = failures;
+			scenarios[j](map, &settings[i]);
+			deleteMap(map);
+			if (failures != previous)
+				fprintf(stderr, "with %s\n", settings[i].name);
+		}
+	}
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+/** @file
+ * Checks that a query whose deadline runs out leaves nothing behind for the
+ * searches run after it in the same workspace.
+ *
+ * The query is bounded by a radius shorter than any road, so if the bound
+ * stayed after the query failed, the next search wouldn't leave the first
+ * city.
+ */
+
+#include <stdio.h>
+#include "check.h"
+#include "city_map.h"
+#include "exclusion.h"
+#include "map.h"
+#include "map_internal.h"
+#include "search.h"
+
+#define CHAIN_LENGTH 10
+#define NAME_LENGTH 16
+
+int main(void) {
+	char name1[NAME_LENGTH], name2[NAME_LENGTH];
+	CityDistance distances[CHAIN_LENGTH];
+	struct timespec past = {.tv_sec = 0, .tv_nsec = 0};
+	size_t length;
+	Map *map = newMap();
+	check(map != NULL, "map created");
+	if (!map)
+		return 1;
+	for (int i = 0; i + 1 < CHAIN_LENGTH; ++i) {
+		snprintf(name1, NAME_LENGTH, "c%d", i);
+		snprintf(name2, NAME_LENGTH, "c%d", i + 1);
+		check(addRoad(map, name1, name2, 10, 2000), "add road");
+	}
+	Search *search = mapGetSearch(map);
+	CityMap *cities = mapGetCities(map);
+	check(exclusionReset(searchExclusion(search), cityMapGetLength(cities)), "reset exclusion");
+	searchBegin(search, mapGetCity(map, "c0"), mapGetCity(map, name2), cities, 1, &past);
+	check(searchStep(search, SIZE_MAX), "query over after the deadline");
+	Road **path = searchResult(search, &length);
+	check(path == NULL && length == 0, "no path after the deadline");
+	check(mapDistancesFrom(map, "c0", distances), "distances found");
+	for (int i = 0; i < CHAIN_LENGTH; ++i) {
+		snprintf(name1, NAME_LENGTH, "c%d", i);
+		check(distances[mapCityId(map, name1)].distance == (size_t) (10 * i), "distance after the query");
+	}
+	check(newRoute(map, 1, "c0", name2), "Route after the query");
+	deleteMap(map);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+/** @file
+ * Checks that the delta-stepping search gives the same distances as the
+ * sequential one when the roads are much longer or much shorter than the
+ * width of a bucket.
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include "check.h"
+#include "map.h"
+
+#define SIDE 6
+#define NAME_LENGTH 16
+
+//! @cond
+static void name(char *dest, unsigned x, unsigned y) {
+	snprintf(dest, NAME_LENGTH, "c%u_%u", x, y);
+}
+
+// a grid of short roads and long ones of a given length
+static bool build(Map *map, unsigned longest) {
+	char a[NAME_LENGTH], b[NAME_LENGTH];
+	for (unsigned x = 0; x < SIDE; ++x) {
+		for (unsigned y = 0; y < SIDE; ++y) {
+			name(a, x, y);
+			if (x + 1 < SIDE) {
+				name(b, x + 1, y);
+				if (!addRoad(map, a, b, (x + y) % 3 == 0 ? longest : 1, 2000 + (int) y))
+					return false;
+			}
+			if (y + 1 < SIDE) {
+				name(b, x, y + 1);
+				if (!addRoad(map, a, b, (x * y) % 4 == 1 ? longest : 1 + x, 2000 + (int) x))
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool same(const CityDistance *expected, const CityDistance *found, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		if (expected[i].distance != found[i].distance || expected[i].year != found[i].year
+				|| expected[i].unique != found[i].unique)
+			return false;
+	}
+	return true;
+}
+
+// compares the distances found with buckets of every width to the sequential search
+static void compare(unsigned longest) {
+	const unsigned deltas[] = {1, 2, 1000, UINT_MAX / 2, UINT_MAX};
+	char what[64];
+	Map *map = newMap();
+	CityDistance *expected = malloc(SIDE * SIDE * sizeof(CityDistance));
+	CityDistance *found = malloc(SIDE * SIDE * sizeof(CityDistance));
+	snprintf(what, sizeof(what), "map with roads of length %u", longest);
+	const bool ready = map && expected && found && build(map, longest) && mapPrepareWorkers(map, 2)
+			&& mapDistancesFrom(map, "c0_0", expected);
+	check(ready, what);
+	if (ready) {
+		for (size_t i = 0; i < sizeof(deltas) / sizeof(deltas[0]); ++i) {
+			mapUseStepping(map, deltas[i]);
+			snprintf(what, sizeof(what), "roads of length %u, delta %u", longest, deltas[i]);
+			check(mapDistancesFrom(map, "c0_0", found) && same(expected, found, mapCityCount(map)), what);
+		}
+	}
+	free(expected);
+	free(found);
+	if (map)
+		deleteMap(map);
+}
+//! @endcond
+
+int main(void) {
+	compare(1000);
+	compare(UINT_MAX);
+	return failures == 0 ? 0 : 1;
+}